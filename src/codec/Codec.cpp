@@ -8,7 +8,20 @@ namespace codec {
 
 std::string Codec::encode(const CodecValue& value)
 {
-    return std::visit(EncoderVisitor {}, value.data);
+    std::string out;
+    encodeInto(value, out);
+    return out;
+}
+
+void Codec::encodeInto(const CodecValue& value, std::string& out)
+{
+    out.reserve(out.size() + encodedSize(value));
+    std::visit(EncoderVisitor { out }, value.data);
+}
+
+size_t Codec::encodedSize(const CodecValue& value)
+{
+    return std::visit(EncodedSizeVisitor {}, value.data);
 }
 
 CodecValue Codec::decode(const std::string& data)
@@ -17,4 +30,16 @@ CodecValue Codec::decode(const std::string& data)
     return decodeValue(data, pos);
 }
 
+std::optional<CodecValue> Codec::tryDecode(const std::string& data, size_t& pos)
+{
+    size_t next = pos;
+    try {
+        CodecValue value = decodeValue(data, next);
+        pos = next;
+        return value;
+    } catch (const IncompleteInput&) {
+        return std::nullopt;
+    }
+}
+
 } // namespace codec
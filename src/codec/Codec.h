@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CodecValue.h"
+#include <optional>
 #include <string>
 
 namespace codec {
@@ -8,6 +9,13 @@ namespace codec {
 class Codec {
 public:
     static std::string encode(const CodecValue& value);
+    // Appends the encoding to out, growing it at most once
+    static void encodeInto(const CodecValue& value, std::string& out);
+    static size_t encodedSize(const CodecValue& value);
     static CodecValue decode(const std::string& data);
+
+    // Decodes the value starting at pos and advances pos past it. Returns
+    // std::nullopt and leaves pos untouched if data holds only part of it.
+    static std::optional<CodecValue> tryDecode(const std::string& data, size_t& pos);
 };
 } // namespace codec
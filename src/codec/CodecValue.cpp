@@ -30,7 +30,7 @@ struct CodecValueComparator {
             return false;
         }
         const auto& rhs_array = std::get<Array>(rhs.data);
-        if (lhs.elements.size() != rhs_array.elements.size()) {
+        if (lhs.null != rhs_array.null || lhs.elements.size() != rhs_array.elements.size()) {
             return false;
         }
         for (size_t i = 0; i < lhs.elements.size(); ++i) {
@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -23,6 +24,7 @@ struct BulkString {
 struct CodecValue;
 struct Array {
     std::vector<CodecValue> elements;
+    bool null = false; // *-1, which has no elements
 };
 
 using CodecVariant = std::variant<SimpleString, Error, Integer, BulkString, Array>;
@@ -50,16 +52,31 @@ inline CodecValue bulk(const std::string& s)
     return CodecValue { BulkString { s } };
 }
 
+inline CodecValue bulk(std::string&& s)
+{
+    return CodecValue { BulkString { std::move(s) } };
+}
+
 inline CodecValue nullBulk()
 {
     return CodecValue { BulkString { std::nullopt } };
 }
 
+inline CodecValue nullArray()
+{
+    return CodecValue { Array { {}, true } };
+}
+
 inline CodecValue array(const std::vector<CodecValue>& vals)
 {
     return CodecValue { Array { vals } };
 }
 
+inline CodecValue array(std::vector<CodecValue>&& vals)
+{
+    return CodecValue { Array { std::move(vals) } };
+}
+
 bool operator==(const CodecValue& lhs, const CodecValue& rhs);
 
 } // namespace codec
\ No newline at end of file
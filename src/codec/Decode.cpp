@@ -1,73 +1,83 @@
 #include "Decode.h"
+#include "Scanner.h"
+#include <algorithm>
+#include <string_view>
 
 namespace codec {
-std::string readLine(const std::string& data, size_t& pos)
+// The line up to the next delimiter, as a view into data
+static std::string_view readLine(const std::string& data, size_t& pos)
 {
-    auto end = data.find(DELIMITER, pos);
+    size_t end = Scanner::findDelimiter(data.data(), data.size(), pos);
     if (end == std::string::npos) {
-        throw std::runtime_error("Missing DELIMITER");
+        throw IncompleteInput("Missing DELIMITER");
     }
-    std::string line = data.substr(pos, end - pos);
+    std::string_view line(data.data() + pos, end - pos);
     pos = end + DELIMITER.size();
     return line;
 }
 
+static long long readNumber(const std::string& data, size_t& pos, const char* error)
+{
+    long long value;
+    if (!Scanner::parseInteger(readLine(data, pos), value)) {
+        throw std::runtime_error(error);
+    }
+    return value;
+}
+
 SimpleString DecodeHelpers::readSimpleString(const std::string& data, size_t& pos)
 {
-    return SimpleString { readLine(data, pos) };
+    return SimpleString { std::string(readLine(data, pos)) };
 }
 
 Error DecodeHelpers::readError(const std::string& data, size_t& pos)
 {
-    return Error { readLine(data, pos) };
+    return Error { std::string(readLine(data, pos)) };
 }
 
 Integer DecodeHelpers::readInteger(const std::string& data, size_t& pos)
 {
-    try {
-        return Integer { std::stoll(readLine(data, pos)) };
-    } catch (const std::exception&) {
-        throw std::runtime_error("Invalid integer format");
-    }
+    return Integer { readNumber(data, pos, "Invalid integer format") };
 }
 
 BulkString DecodeHelpers::readBulkString(const std::string& data, size_t& pos)
 {
-    int len;
-    try {
-        len = std::stoi(readLine(data, pos));
-    } catch (const std::exception&) {
-        throw std::runtime_error("Invalid BulkString format");
-    }
+    long long len = readNumber(data, pos, "Invalid BulkString format");
 
     if (len == -1)
         return BulkString { std::nullopt };
+    if (len < 0)
+        throw std::runtime_error("Invalid BulkString format");
 
-    if (pos + len + DELIMITER.size() > data.size()) {
-        throw std::runtime_error("Truncated bulk string");
+    if (static_cast<size_t>(len) + DELIMITER.size() > data.size() - pos) {
+        throw IncompleteInput("Truncated bulk string");
     }
 
     std::string bulk = data.substr(pos, len);
     pos += len + DELIMITER.size();
-    return BulkString { bulk };
+    return BulkString { std::move(bulk) };
 }
 
 Array DecodeHelpers::readArray(const std::string& data, size_t& pos)
 {
-    int count;
-    try {
-        count = std::stoi(readLine(data, pos));
-    } catch (const std::exception&) {
-        throw std::runtime_error("Invalid integer format");
-    }
+    long long count = readNumber(data, pos, "Invalid integer format");
 
     if (count == -1)
-        return Array { {} };
+        return Array { {}, true };
+    if (count < 0)
+        throw std::runtime_error("Invalid integer format");
 
+    // Don't trust the peer's count for more than this up front
     Array arr;
-    arr.elements.reserve(count);
-    for (int i = 0; i < count; ++i) {
-        arr.elements.push_back(decodeValue(data, pos));
+    arr.elements.reserve(std::min<long long>(count, 1024));
+    for (long long i = 0; i < count; ++i) {
+        // Requests are arrays of bulk strings: read those without dispatching
+        if (pos < data.size() && data[pos] == MARKER_BULK_STRING) {
+            ++pos;
+            arr.elements.push_back(CodecValue { readBulkString(data, pos) });
+        } else {
+            arr.elements.push_back(decodeValue(data, pos));
+        }
     }
     return arr;
 }
@@ -1,14 +1,19 @@
 #pragma once
 #include "CodecValue.h"
 #include "Marker.h"
-#include <functional>
-#include <map>
+#include <array>
 #include <stdexcept>
 
 using namespace std::string_literals;
 
 namespace codec {
 
+// Thrown when the input ends before the value being decoded does. Callers
+// reading from a stream can catch it and retry once more bytes arrive.
+struct IncompleteInput : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
 struct DecodeHelpers {
     static SimpleString readSimpleString(const std::string& d, size_t& p);
     static Error readError(const std::string& d, size_t& p);
@@ -17,30 +22,31 @@ struct DecodeHelpers {
     static Array readArray(const std::string& d, size_t& p);
 };
 
+// Decoder per type byte, indexed directly by it. Bytes that don't start a
+// RESP value map to nullptr.
 struct DecodeDispatch {
-    using Fn = std::function<CodecValue(const std::string&, size_t&)>;
-    static const std::map<char, Fn>& table()
-    {
-        static const std::map<MarkerType, Fn> t = {
-            { MARKER_SIMPLE_STRING, [](auto& d, auto& p) { return CodecValue { DecodeHelpers::readSimpleString(d, p) }; } },
-            { MARKER_ERROR, [](auto& d, auto& p) { return CodecValue { DecodeHelpers::readError(d, p) }; } },
-            { MARKER_INTEGER, [](auto& d, auto& p) { return CodecValue { DecodeHelpers::readInteger(d, p) }; } },
-            { MARKER_BULK_STRING, [](auto& d, auto& p) { return CodecValue { DecodeHelpers::readBulkString(d, p) }; } },
-            { MARKER_ARRAY, [](auto& d, auto& p) { return CodecValue { DecodeHelpers::readArray(d, p) }; } }
-        };
+    using Fn = CodecValue (*)(const std::string&, size_t&);
+
+    static constexpr std::array<Fn, 256> table = [] {
+        std::array<Fn, 256> t {};
+        t[static_cast<unsigned char>(MARKER_SIMPLE_STRING)] = [](const std::string& d, size_t& p) { return CodecValue { DecodeHelpers::readSimpleString(d, p) }; };
+        t[static_cast<unsigned char>(MARKER_ERROR)] = [](const std::string& d, size_t& p) { return CodecValue { DecodeHelpers::readError(d, p) }; };
+        t[static_cast<unsigned char>(MARKER_INTEGER)] = [](const std::string& d, size_t& p) { return CodecValue { DecodeHelpers::readInteger(d, p) }; };
+        t[static_cast<unsigned char>(MARKER_BULK_STRING)] = [](const std::string& d, size_t& p) { return CodecValue { DecodeHelpers::readBulkString(d, p) }; };
+        t[static_cast<unsigned char>(MARKER_ARRAY)] = [](const std::string& d, size_t& p) { return CodecValue { DecodeHelpers::readArray(d, p) }; };
         return t;
-    }
+    }();
 };
 
 inline CodecValue decodeValue(const std::string& data, size_t& pos)
 {
     if (pos >= data.size())
-        throw std::runtime_error("Unexpected end of input");
+        throw IncompleteInput("Unexpected end of input");
     char prefix = data[pos++];
-    auto it = DecodeDispatch::table().find(prefix);
-    if (it == DecodeDispatch::table().end())
+    DecodeDispatch::Fn decode = DecodeDispatch::table[static_cast<unsigned char>(prefix)];
+    if (!decode)
         throw std::runtime_error("Unknown prefix: "s + prefix);
-    return it->second(data, pos);
+    return decode(data, pos);
 }
 
 } // namespace codec
@@ -1,38 +1,140 @@
 #pragma once
 #include "CodecValue.h"
 #include "Marker.h"
+#include <array>
+#include <charconv>
 #include <string>
+#include <string_view>
 
 using namespace std::literals::string_literals;
 
 namespace codec {
 
-struct EncoderVisitor {
-    std::string operator()(const SimpleString& s) const
+// Replies common enough to be kept encoded
+constexpr std::string_view ENCODED_OK = "+OK\r\n";
+constexpr std::string_view ENCODED_NULL_BULK = "$-1\r\n";
+constexpr std::string_view ENCODED_EMPTY_ARRAY = "*0\r\n";
+constexpr std::string_view ENCODED_NULL_ARRAY = "*-1\r\n";
+constexpr long long SHARED_INTEGERS = 1024; // :0 up to :1023
+
+// The encoding of integer value, for 0 <= value < SHARED_INTEGERS
+inline std::string_view sharedInteger(long long value)
+{
+    static const auto table = [] {
+        std::array<std::string, SHARED_INTEGERS> encoded;
+        for (long long i = 0; i < SHARED_INTEGERS; ++i)
+            encoded[i] = MARKER_INTEGER + std::to_string(i) + DELIMITER;
+        return encoded;
+    }();
+    return table[value];
+}
+
+inline size_t decimalLength(long long value)
+{
+    size_t len = value < 0 ? 2 : 1;
+    unsigned long long rest = value < 0 ? 0ULL - value : value;
+    while (rest >= 10) {
+        rest /= 10;
+        ++len;
+    }
+    return len;
+}
+
+// Exact number of bytes a value encodes to, so the output can be sized once
+struct EncodedSizeVisitor {
+    size_t operator()(const SimpleString& s) const
     {
-        return MARKER_SIMPLE_STRING + s.value + DELIMITER;
+        return 1 + s.value.size() + DELIMITER.size();
     }
-    std::string operator()(const Error& e) const
+    size_t operator()(const Error& e) const
     {
-        return MARKER_ERROR + e.value + DELIMITER;
+        return 1 + e.value.size() + DELIMITER.size();
     }
-    std::string operator()(const Integer& i) const
+    size_t operator()(const Integer& i) const
     {
-        return MARKER_INTEGER + std::to_string(i.value) + DELIMITER;
+        return 1 + decimalLength(i.value) + DELIMITER.size();
     }
-    std::string operator()(const BulkString& b) const
+    size_t operator()(const BulkString& b) const
     {
         if (!b.value)
-            return MARKER_BULK_STRING + "-1"s + DELIMITER;
-        return MARKER_BULK_STRING + std::to_string(b.value->size()) + DELIMITER + *b.value + DELIMITER;
+            return ENCODED_NULL_BULK.size();
+        return 1 + decimalLength(b.value->size()) + DELIMITER.size() + b.value->size() + DELIMITER.size();
     }
-    std::string operator()(const Array& arr) const
+    size_t operator()(const Array& arr) const
     {
-        std::string out = MARKER_ARRAY + std::to_string(arr.elements.size()) + DELIMITER;
+        if (arr.null)
+            return ENCODED_NULL_ARRAY.size();
+        size_t size = 1 + decimalLength(arr.elements.size()) + DELIMITER.size();
         for (const auto& [data] : arr.elements) {
-            out += std::visit(EncoderVisitor {}, data);
+            size += std::visit(*this, data);
         }
-        return out;
+        return size;
+    }
+};
+
+// Appends the encoding to out, which the caller has already sized
+struct EncoderVisitor {
+    std::string& out;
+
+    void operator()(const SimpleString& s) const
+    {
+        if (s.value == "OK") {
+            out += ENCODED_OK;
+            return;
+        }
+        out += MARKER_SIMPLE_STRING;
+        out += s.value;
+        out += DELIMITER;
+    }
+    void operator()(const Error& e) const
+    {
+        out += MARKER_ERROR;
+        out += e.value;
+        out += DELIMITER;
+    }
+    void operator()(const Integer& i) const
+    {
+        if (i.value >= 0 && i.value < SHARED_INTEGERS) {
+            out += sharedInteger(i.value);
+            return;
+        }
+        header(MARKER_INTEGER, i.value);
+    }
+    void operator()(const BulkString& b) const
+    {
+        if (!b.value) {
+            out += ENCODED_NULL_BULK;
+            return;
+        }
+        header(MARKER_BULK_STRING, static_cast<long long>(b.value->size()));
+        out += *b.value;
+        out += DELIMITER;
+    }
+    void operator()(const Array& arr) const
+    {
+        if (arr.null) {
+            out += ENCODED_NULL_ARRAY;
+            return;
+        }
+        if (arr.elements.empty()) {
+            out += ENCODED_EMPTY_ARRAY;
+            return;
+        }
+        header(MARKER_ARRAY, static_cast<long long>(arr.elements.size()));
+        for (const auto& [data] : arr.elements) {
+            std::visit(*this, data);
+        }
+    }
+
+    // Marker, number and delimiter, formatted without a temporary string
+    void header(MarkerType marker, long long value) const
+    {
+        char buffer[24];
+        buffer[0] = marker;
+        char* end = std::to_chars(buffer + 1, buffer + sizeof(buffer), value).ptr;
+        *end++ = '\r';
+        *end++ = '\n';
+        out.append(buffer, end);
     }
 };
 
@@ -0,0 +1,145 @@
+#include "Scanner.h"
+#include <atomic>
+#include <charconv>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CODEC_HAVE_X86 1
+#endif
+
+namespace codec {
+
+namespace {
+    using FindFn = size_t (*)(const char*, size_t, size_t);
+
+    size_t findScalar(const char* data, size_t len, size_t from)
+    {
+        for (size_t i = from; i + 1 < len; ++i) {
+            if (data[i] == '\r' && data[i + 1] == '\n')
+                return i;
+        }
+        return std::string::npos;
+    }
+
+#ifdef CODEC_HAVE_X86
+    // Each step compares a block against '\r' and the same block shifted by
+    // one byte against '\n'; a set bit in both masks is a delimiter. The
+    // shifted load reads one byte past the block, so the loop stops a byte
+    // early and the scalar loop finishes the tail.
+    __attribute__((target("sse2"))) size_t findSse2(const char* data, size_t len, size_t from)
+    {
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i lf = _mm_set1_epi8('\n');
+        size_t i = from;
+        for (; i + 16 < len; i += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+            unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block, cr), _mm_cmpeq_epi8(next, lf)));
+            if (mask)
+                return i + __builtin_ctz(mask);
+        }
+        return findScalar(data, len, i);
+    }
+
+    __attribute__((target("avx2"))) size_t findAvx2(const char* data, size_t len, size_t from)
+    {
+        const __m256i cr = _mm256_set1_epi8('\r');
+        const __m256i lf = _mm256_set1_epi8('\n');
+        size_t i = from;
+        for (; i + 32 < len; i += 32) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+            unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(block, cr), _mm256_cmpeq_epi8(next, lf)));
+            if (mask)
+                return i + __builtin_ctz(mask);
+        }
+        return findSse2(data, len, i);
+    }
+#endif
+
+    FindFn finder(ScanBackend backend)
+    {
+        switch (backend) {
+#ifdef CODEC_HAVE_X86
+        case ScanBackend::Avx2:
+            return findAvx2;
+        case ScanBackend::Sse2:
+            return findSse2;
+#endif
+        default:
+            return findScalar;
+        }
+    }
+
+    ScanBackend bestBackend()
+    {
+        if (Scanner::supported(ScanBackend::Avx2))
+            return ScanBackend::Avx2;
+        if (Scanner::supported(ScanBackend::Sse2))
+            return ScanBackend::Sse2;
+        return ScanBackend::Scalar;
+    }
+
+    // Usable from the start; upgraded to the best backend before main()
+    std::atomic<ScanBackend> activeBackend { ScanBackend::Scalar };
+    std::atomic<FindFn> activeFinder { findScalar };
+    [[maybe_unused]] const bool selected = Scanner::setBackend(bestBackend());
+} // namespace
+
+size_t Scanner::findDelimiter(const char* data, size_t len, size_t from)
+{
+    return activeFinder.load(std::memory_order_relaxed)(data, len, from);
+}
+
+bool Scanner::parseInteger(std::string_view digits, long long& value)
+{
+    auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    return ec == std::errc() && end == digits.data() + digits.size() && !digits.empty();
+}
+
+ScanBackend Scanner::backend()
+{
+    return activeBackend.load(std::memory_order_relaxed);
+}
+
+bool Scanner::setBackend(ScanBackend backend)
+{
+    if (!supported(backend))
+        return false;
+    activeBackend.store(backend, std::memory_order_relaxed);
+    activeFinder.store(finder(backend), std::memory_order_relaxed);
+    return true;
+}
+
+bool Scanner::supported(ScanBackend backend)
+{
+#ifdef CODEC_HAVE_X86
+    __builtin_cpu_init(); // May run before the CPU model is otherwise set up
+#endif
+    switch (backend) {
+    case ScanBackend::Scalar:
+        return true;
+#ifdef CODEC_HAVE_X86
+    case ScanBackend::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case ScanBackend::Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* Scanner::name(ScanBackend backend)
+{
+    switch (backend) {
+    case ScanBackend::Sse2:
+        return "sse2";
+    case ScanBackend::Avx2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+} // namespace codec
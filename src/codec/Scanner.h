@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace codec {
+
+// Finds the CRLF that ends each RESP header line. The vector backends test
+// a whole block of bytes per step; the scalar one is the portable fallback.
+enum class ScanBackend {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+class Scanner {
+public:
+    // Offset of the first "\r\n" at or after from, or std::string::npos
+    static size_t findDelimiter(const char* data, size_t len, size_t from);
+
+    // Parses a whole decimal integer without allocating or throwing.
+    // Returns false if digits isn't exactly one in-range number.
+    static bool parseInteger(std::string_view digits, long long& value);
+
+    // Defaults to the fastest backend the CPU supports
+    static ScanBackend backend();
+    // Returns false, changing nothing, if the CPU doesn't support backend
+    static bool setBackend(ScanBackend backend);
+    static bool supported(ScanBackend backend);
+    static const char* name(ScanBackend backend);
+};
+
+} // namespace codec
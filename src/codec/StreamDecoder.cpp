@@ -0,0 +1,274 @@
+#include "StreamDecoder.h"
+#include "Marker.h"
+#include "Scanner.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace codec {
+
+namespace {
+    // Don't trust a peer-supplied element count for more than this up front
+    constexpr size_t MAX_ARRAY_RESERVE = 1024;
+    // Nor a bulk length: room for more than this is only made as bytes arrive
+    constexpr size_t MAX_BULK_RESERVE = 1024 * 1024;
+    // Longest bulk string accepted, as Redis's default proto-max-bulk-len
+    constexpr long long MAX_BULK_LENGTH = 512LL * 1024 * 1024;
+
+    size_t bulkLength(long long len)
+    {
+        if (len < 0)
+            throw std::runtime_error("Invalid BulkString format");
+        if (len > MAX_BULK_LENGTH)
+            throw std::runtime_error("invalid bulk length");
+        return static_cast<size_t>(len);
+    }
+
+    long long parseNumber(std::string_view line, const char* what)
+    {
+        long long value = 0;
+        if (!Scanner::parseInteger(line, value))
+            throw std::runtime_error(what);
+        return value;
+    }
+
+    // Reads the digits and delimiter of a length header at p. Returns false,
+    // without reporting why, if they're malformed or haven't all arrived.
+    bool scanLength(const char*& p, const char* end, size_t& len)
+    {
+        const char* digits = p;
+        len = 0;
+        while (p < end && *p >= '0' && *p <= '9' && p - digits < 18)
+            len = len * 10 + (*p++ - '0');
+        if (p == digits || end - p < 2 || p[0] != '\r' || p[1] != '\n')
+            return false;
+        p += DELIMITER.size();
+        return true;
+    }
+} // namespace
+
+void StreamDecoder::feed(const char* data, size_t len)
+{
+    compact();
+    // Grow once for a whole bulk payload instead of once per read, up to a
+    // point: the length is the peer's word
+    if (state_ == State::Payload)
+        buffer_.reserve(pos_ + std::min(payloadLen_ + DELIMITER.size(), MAX_BULK_RESERVE));
+    buffer_.append(data, len);
+}
+
+std::optional<CodecValue> StreamDecoder::next()
+{
+    CodecValue value;
+    while (true) {
+        Step step = state_ == State::Header ? readHeader(value) : readPayload(value);
+        if (step == Step::NeedMore)
+            return std::nullopt;
+        if (step == Step::Value && attach(value))
+            return value;
+    }
+}
+
+bool StreamDecoder::nextCommand(std::vector<std::string_view>& args)
+{
+    if (!inCommand_ && readWholeCommand(args))
+        return true;
+
+    while (true) {
+        if (state_ == State::Payload) {
+            if (buffer_.size() - pos_ < payloadLen_ + DELIMITER.size())
+                return false;
+            if (buffer_.compare(pos_ + payloadLen_, DELIMITER.size(), DELIMITER) != 0)
+                throw std::runtime_error("Missing DELIMITER");
+            spans_.emplace_back(pos_, payloadLen_);
+            pos_ = scanPos_ = pos_ + payloadLen_ + DELIMITER.size();
+            state_ = State::Header;
+        } else {
+            size_t start = pos_;
+            char prefix;
+            std::string_view line;
+            if (!readLine(prefix, line))
+                return false;
+
+            if (!inCommand_) {
+                if (prefix != MARKER_ARRAY)
+                    throw std::runtime_error("Expected an array of bulk strings");
+                long long count = parseNumber(line, "Invalid integer format");
+                if (count < -1)
+                    throw std::runtime_error("Invalid integer format");
+                inCommand_ = true;
+                commandStart_ = start;
+                commandArgs_ = count > 0 ? static_cast<size_t>(count) : 0;
+                spans_.reserve(std::min(commandArgs_, MAX_ARRAY_RESERVE));
+            } else {
+                if (prefix != MARKER_BULK_STRING)
+                    throw std::runtime_error("Expected a bulk string argument");
+                payloadLen_ = bulkLength(parseNumber(line, "Invalid BulkString format"));
+                state_ = State::Payload;
+                continue;
+            }
+        }
+
+        if (spans_.size() == commandArgs_) {
+            for (auto [offset, len] : spans_)
+                args.emplace_back(buffer_.data() + offset, len);
+            spans_.clear();
+            inCommand_ = false;
+            return true;
+        }
+    }
+}
+
+// Fast path for a request that has fully arrived, which is nearly always the
+// case: one tight loop over its bulk strings. Anything else, including
+// malformed input, is left untouched for the general path above.
+bool StreamDecoder::readWholeCommand(std::vector<std::string_view>& args)
+{
+    const char* p = buffer_.data() + pos_;
+    const char* end = buffer_.data() + buffer_.size();
+    size_t count;
+    if (p == end || *p++ != MARKER_ARRAY || !scanLength(p, end, count) || count == 0)
+        return false;
+
+    size_t first = args.size();
+    for (size_t i = 0; i < count; ++i) {
+        size_t len;
+        if (p == end || *p++ != MARKER_BULK_STRING || !scanLength(p, end, len)
+            || static_cast<size_t>(end - p) < len + DELIMITER.size() || p[len] != '\r' || p[len + 1] != '\n') {
+            args.resize(first);
+            return false;
+        }
+        args.emplace_back(p, len);
+        p += len + DELIMITER.size();
+    }
+
+    pos_ = scanPos_ = p - buffer_.data();
+    return true;
+}
+
+size_t StreamDecoder::buffered() const
+{
+    return buffer_.size() - pos_;
+}
+
+// Consumes the next CRLF-terminated line, split into its type prefix and the
+// rest. Returns false if the line hasn't fully arrived yet.
+bool StreamDecoder::readLine(char& prefix, std::string_view& line)
+{
+    if (pos_ >= buffer_.size())
+        return false;
+
+    size_t end = Scanner::findDelimiter(buffer_.data(), buffer_.size(), std::max(scanPos_, pos_ + 1));
+    if (end == std::string::npos) {
+        // A CR at the very end may be the first half of the delimiter
+        scanPos_ = std::max(pos_ + 1, buffer_.size() - 1);
+        return false;
+    }
+
+    prefix = buffer_[pos_];
+    line = std::string_view(buffer_.data() + pos_ + 1, end - pos_ - 1);
+    pos_ = scanPos_ = end + DELIMITER.size();
+    return true;
+}
+
+StreamDecoder::Step StreamDecoder::readHeader(CodecValue& value)
+{
+    char prefix;
+    std::string_view line;
+    if (!readLine(prefix, line))
+        return Step::NeedMore;
+
+    switch (prefix) {
+    case MARKER_SIMPLE_STRING:
+        value = CodecValue { SimpleString { std::string(line) } };
+        return Step::Value;
+    case MARKER_ERROR:
+        value = CodecValue { Error { std::string(line) } };
+        return Step::Value;
+    case MARKER_INTEGER:
+        value = CodecValue { Integer { parseNumber(line, "Invalid integer format") } };
+        return Step::Value;
+    case MARKER_BULK_STRING: {
+        long long len = parseNumber(line, "Invalid BulkString format");
+        if (len == -1) {
+            value = nullBulk();
+            return Step::Value;
+        }
+        payloadLen_ = bulkLength(len);
+        state_ = State::Payload;
+        return Step::Continue;
+    }
+    case MARKER_ARRAY: {
+        long long count = parseNumber(line, "Invalid integer format");
+        if (count == -1) {
+            value = nullArray();
+            return Step::Value;
+        }
+        if (count == 0) {
+            value = array({});
+            return Step::Value;
+        }
+        if (count < 0)
+            throw std::runtime_error("Invalid integer format");
+        Frame frame { Array {}, static_cast<size_t>(count) };
+        frame.array.elements.reserve(std::min(frame.remaining, MAX_ARRAY_RESERVE));
+        stack_.push_back(std::move(frame));
+        return Step::Continue;
+    }
+    default:
+        throw std::runtime_error("Unknown prefix: "s + prefix);
+    }
+}
+
+StreamDecoder::Step StreamDecoder::readPayload(CodecValue& value)
+{
+    if (buffer_.size() - pos_ < payloadLen_ + DELIMITER.size())
+        return Step::NeedMore;
+    if (buffer_.compare(pos_ + payloadLen_, DELIMITER.size(), DELIMITER) != 0)
+        throw std::runtime_error("Missing DELIMITER");
+
+    value = bulk(buffer_.substr(pos_, payloadLen_));
+    pos_ = scanPos_ = pos_ + payloadLen_ + DELIMITER.size();
+    state_ = State::Header;
+    return Step::Value;
+}
+
+// Adds a finished value to the innermost open array, closing every array it
+// completes. Returns true once the outermost value is done.
+bool StreamDecoder::attach(CodecValue& value)
+{
+    while (!stack_.empty()) {
+        Frame& top = stack_.back();
+        top.array.elements.push_back(std::move(value));
+        if (--top.remaining > 0)
+            return false;
+        value = CodecValue { std::move(top.array) };
+        stack_.pop_back();
+    }
+    return true;
+}
+
+// Drops consumed bytes, keeping any partly decoded request. Only moves data
+// once at least half the buffer is consumed so the cost stays amortized over
+// the bytes received.
+void StreamDecoder::compact()
+{
+    size_t keep = inCommand_ ? commandStart_ : pos_;
+    if (keep == 0)
+        return;
+    if (keep == buffer_.size()) {
+        buffer_.clear();
+    } else if (keep >= buffer_.size() / 2) {
+        buffer_.erase(0, keep);
+    } else {
+        return;
+    }
+    pos_ -= keep;
+    scanPos_ -= keep;
+    commandStart_ -= std::min(commandStart_, keep);
+    for (auto& span : spans_)
+        span.first -= keep;
+}
+
+} // namespace codec
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CodecValue.h"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace codec {
+
+// Incremental RESP decoder for data arriving in arbitrary chunks. Bytes are
+// appended with feed() and values pulled with next(). A value split across
+// reads is resumed where parsing stopped, so each byte is examined once no
+// matter how many reads it takes to arrive.
+//
+// Client requests can instead be pulled with nextCommand(), which decodes
+// an array of bulk strings into views of the input buffer without copying
+// them. A decoder should be read in one mode only.
+class StreamDecoder {
+public:
+    // Invalidates the views returned by nextCommand()
+    void feed(const char* data, size_t len);
+
+    // Returns the next complete value, or std::nullopt when more bytes are
+    // needed. Throws std::runtime_error on malformed input.
+    std::optional<CodecValue> next();
+
+    // Appends the arguments of the next complete request to args and returns
+    // true, or returns false when more bytes are needed. The views stay valid
+    // until the next call to feed(). Throws std::runtime_error on malformed
+    // input, including anything other than an array of bulk strings.
+    bool nextCommand(std::vector<std::string_view>& args);
+
+    // Bytes received but not yet consumed by the parser
+    size_t buffered() const;
+
+private:
+    enum class State {
+        Header,
+        Payload
+    };
+    enum class Step {
+        NeedMore,
+        Continue,
+        Value
+    };
+    struct Frame {
+        Array array;
+        size_t remaining;
+    };
+
+    bool readWholeCommand(std::vector<std::string_view>& args);
+    bool readLine(char& prefix, std::string_view& line);
+    Step readHeader(CodecValue& value);
+    Step readPayload(CodecValue& value);
+    bool attach(CodecValue& value);
+    void compact();
+
+    std::string buffer_;
+    size_t pos_ = 0; // First byte not yet consumed
+    size_t scanPos_ = 0; // Where the next delimiter search resumes
+    State state_ = State::Header;
+    size_t payloadLen_ = 0;
+    std::vector<Frame> stack_; // Arrays still waiting for elements
+
+    // Request being decoded by nextCommand()
+    bool inCommand_ = false;
+    size_t commandStart_ = 0; // Kept in the buffer until the request is done
+    size_t commandArgs_ = 0;
+    std::vector<std::pair<size_t, size_t>> spans_; // Offset and length per argument
+};
+
+} // namespace codec
@@ -2,35 +2,90 @@
 
 #include "Codec.h"
 #include <algorithm>
-#include <stdexcept>
+#include <charconv>
+#include <cmath>
 #include <string>
 
 namespace command {
-std::string toUpper(const std::string& str)
+std::string toUpper(std::string_view str)
 {
-    std::string result = str;
+    std::string result(str);
     std::transform(result.begin(), result.end(), result.begin(), ::toupper);
     return result;
 }
 
-std::string extractBulkString(const codec::CodecValue& val)
+std::string toLower(std::string_view str)
 {
-    if (auto* bulk = std::get_if<codec::BulkString>(&val.data)) {
-        if (bulk->value) {
-            return *bulk->value;
-        }
-        throw std::runtime_error("Null bulk string");
-    }
-    throw std::runtime_error("Expected bulk string");
+    std::string result(str);
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+}
+
+// from_chars doesn't take the explicit plus sign that strtoll and strtod do
+static std::string_view dropPlusSign(std::string_view str)
+{
+    if (str.size() > 1 && str[0] == '+' && str[1] != '-')
+        str.remove_prefix(1);
+    return str;
+}
+
+bool parseInteger(std::string_view str, long long& value)
+{
+    str = dropPlusSign(str);
+    auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    return ec == std::errc() && end == str.data() + str.size() && !str.empty();
+}
+
+bool parseDouble(std::string_view str, double& value)
+{
+    str = dropPlusSign(str);
+    auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    // NaN has no place in an ordering, so no command takes it
+    return ec == std::errc() && end == str.data() + str.size() && !str.empty() && !std::isnan(value);
+}
+
+bool parseDouble(std::string_view str, long double& value)
+{
+    str = dropPlusSign(str);
+    auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    return ec == std::errc() && end == str.data() + str.size() && !str.empty() && !std::isnan(value);
+}
+
+std::string formatDouble(double value)
+{
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, end);
+}
+
+codec::CodecValue notIntegerError()
+{
+    return codec::err("ERR value is not an integer or out of range");
+}
+
+codec::CodecValue notFloatError()
+{
+    return codec::err("ERR value is not a valid float");
+}
+
+codec::CodecValue syntaxError()
+{
+    return codec::err("ERR syntax error");
 }
 
-long long parseInteger(const std::string& str)
+codec::CodecValue storeError(storage::StoreError error, codec::CodecValue missing)
 {
-    return std::stoll(str);
+    if (error == storage::StoreError::WrongType)
+        return codec::err("WRONGTYPE Operation against a key holding the wrong kind of value");
+    return missing;
 }
 
-double parseDouble(const std::string& str)
+codec::CodecValue bulkArray(std::vector<std::optional<std::string>> values)
 {
-    return std::stod(str);
+    std::vector<codec::CodecValue> replies;
+    replies.reserve(values.size());
+    for (auto& value : values)
+        replies.push_back(value ? codec::bulk(std::move(*value)) : codec::nullBulk());
+    return codec::array(std::move(replies));
 }
 } // namespace command
\ No newline at end of file
@@ -1,11 +1,35 @@
 #pragma once
 
 #include "Codec.h"
+#include "Result.h"
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace command {
-std::string toUpper(const std::string& str);
-std::string extractBulkString(const codec::CodecValue& val);
-long long parseInteger(const std::string& str);
-double parseDouble(const std::string& str);
+// Arguments of one request, command name first. The views point into the
+// connection's input buffer; copy out anything that has to outlive the call.
+using CommandArgs = std::span<const std::string_view>;
+
+std::string toUpper(std::string_view str);
+std::string toLower(std::string_view str);
+// Return false if str isn't exactly one number in range. parseDouble
+// refuses NaN as well.
+bool parseInteger(std::string_view str, long long& value);
+bool parseDouble(std::string_view str, double& value);
+// For INCRBYFLOAT, which adds in long double as Redis does
+bool parseDouble(std::string_view str, long double& value);
+// Shortest text that reads back as value: "2", "0.1", "inf"
+std::string formatDouble(double value);
+
+codec::CodecValue notIntegerError();
+codec::CodecValue notFloatError();
+codec::CodecValue syntaxError();
+// WRONGTYPE for a key of another type, otherwise the command's reply for a
+// missing key
+codec::CodecValue storeError(storage::StoreError error, codec::CodecValue missing);
+// MGET and HMGET: a bulk string per value, null where there is none
+codec::CodecValue bulkArray(std::vector<std::optional<std::string>> values);
 } // namespace command
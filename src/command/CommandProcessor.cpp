@@ -1,46 +1,18 @@
 #include "CommandProcessor.h"
 #include "CommandHelpers.h"
-#include "HashCommands.h"
-#include "ListCommands.h"
-#include "SetCommands.h"
-#include "SortedSetCommands.h"
-#include "StringCommands.h"
+#include "CommandTable.h"
 #include <algorithm>
-#include <functional>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 
 namespace command {
 
-using CommandHandler = std::function<codec::CodecValue(storage::KeyValueStore&, const std::vector<codec::CodecValue>&)>;
-
-const std::unordered_map<std::string, CommandHandler> commandMap = {
-    { "SET", cmdSet },
-    { "GET", cmdGet },
-    { "DEL", cmdDel },
-    { "EXISTS", cmdExists },
-    { "LPUSH", cmdLPush },
-    { "RPUSH", cmdRPush },
-    { "LPOP", cmdLPop },
-    { "RPOP", cmdRPop },
-    { "LRANGE", cmdLRange },
-    { "SADD", cmdSAdd },
-    { "SREM", cmdSRem },
-    { "SMEMBERS", cmdSMembers },
-    { "HSET", cmdHSet },
-    { "HGET", cmdHGet },
-    { "HDEL", cmdHDel },
-    { "HGETALL", cmdHGetAll },
-    { "ZADD", cmdZAdd },
-    { "ZREM", cmdZRem },
-    { "ZRANGE", cmdZRange }
-};
-
 CommandProcessor::CommandProcessor(storage::KeyValueStore& kvStore)
     : kvStore_(kvStore)
 {
 }
 
-codec::CodecValue CommandProcessor::process(const codec::CodecValue& msg) const
+codec::CodecValue CommandProcessor::process(const codec::CodecValue& msg)
 {
     // Extract array from message
     const codec::Array* arr = std::get_if<codec::Array>(&msg.data);
@@ -48,21 +20,120 @@ codec::CodecValue CommandProcessor::process(const codec::CodecValue& msg) const
         return codec::err("ERR empty command");
     }
 
-    // Extract command name
-    std::string command;
-    try {
-        command = toUpper(extractBulkString(arr->elements[0]));
-    } catch (const std::exception& e) {
-        return codec::err("ERR invalid command format");
+    // View every argument in place
+    std::vector<std::string_view> args;
+    args.reserve(arr->elements.size());
+    for (const codec::CodecValue& element : arr->elements) {
+        const auto* bulk = std::get_if<codec::BulkString>(&element.data);
+        if (!bulk || !bulk->value) {
+            return codec::err("ERR invalid command format");
+        }
+        args.emplace_back(*bulk->value);
+    }
+
+    return execute(args);
+}
+
+codec::CodecValue CommandProcessor::execute(CommandArgs args)
+{
+    if (auto error = check(args)) {
+        return std::move(*error);
+    }
+    const CommandSpec* spec = findCommand(args[0]);
+
+    if (spec->has(CommandSpec::Transaction)) {
+        // Only reached from a MULTI block, where the connection handles
+        // everything but UNWATCH; by then EXEC has released the watches
+        if (spec->name == "UNWATCH") {
+            return codec::ok();
+        }
+        return codec::err("ERR " + toLower(spec->name) + " is only valid on a connection");
+    }
+
+    codec::CodecValue reply = spec->handler(kvStore_, args);
+    if (spec->has(CommandSpec::Write) && !watchers_.empty()) {
+        forEachKey(*spec, args, [this](std::string_view key) { touch(key); });
     }
+    return reply;
+}
 
-    // Look up and execute command
-    auto it = commandMap.find(command);
-    if (it != commandMap.end()) {
-        return it->second(kvStore_, arr->elements);
+std::optional<codec::CodecValue> CommandProcessor::check(CommandArgs args)
+{
+    if (args.empty()) {
+        return codec::err("ERR empty command");
     }
 
-    return codec::err("ERR unknown command '" + command + "'");
+    // Look up the command and check its arity before running it
+    const CommandSpec* spec = findCommand(args[0]);
+    if (!spec) {
+        return codec::err("ERR unknown command '" + toUpper(args[0]) + "'");
+    }
+    if (!spec->acceptsArgCount(args.size())) {
+        return codec::err("ERR wrong number of arguments for '" + toLower(spec->name) + "' command");
+    }
+    return std::nullopt;
+}
+
+void CommandProcessor::watch(WatcherId watcher, CommandArgs keys)
+{
+    Watch& watch = watches_[watcher];
+    for (std::string_view key : keys) {
+        if (std::find(watch.keys.begin(), watch.keys.end(), key) != watch.keys.end()) {
+            continue;
+        }
+        watch.keys.emplace_back(key);
+        auto it = watchers_.find(key);
+        if (it == watchers_.end()) {
+            it = watchers_.emplace(std::string(key), std::vector<WatcherId> {}).first;
+        }
+        it->second.push_back(watcher);
+    }
+}
+
+void CommandProcessor::unwatch(WatcherId watcher)
+{
+    auto watch = watches_.find(watcher);
+    if (watch == watches_.end()) {
+        return;
+    }
+    for (const std::string& key : watch->second.keys) {
+        auto it = watchers_.find(key);
+        std::erase(it->second, watcher);
+        if (it->second.empty()) {
+            watchers_.erase(it);
+        }
+    }
+    watches_.erase(watch);
+}
+
+codec::CodecValue CommandProcessor::exec(WatcherId watcher, CommandArgs args, std::span<const size_t> requests)
+{
+    auto watch = watches_.find(watcher);
+    bool spoiled = watch != watches_.end() && watch->second.spoiled;
+    unwatch(watcher);
+    if (spoiled) {
+        return codec::nullArray();
+    }
+
+    std::vector<codec::CodecValue> replies;
+    replies.reserve(requests.size());
+    size_t first = 0;
+    for (size_t count : requests) {
+        replies.push_back(execute(args.subspan(first, count)));
+        first += count;
+    }
+    return codec::array(std::move(replies));
+}
+
+void CommandProcessor::touch(std::string_view key)
+{
+    auto it = watchers_.find(key);
+    if (it == watchers_.end()) {
+        return;
+    }
+    for (WatcherId watcher : it->second) {
+        watches_[watcher].spoiled = true;
+    }
 }
 
-} // namespace command
\ No newline at end of file
+} // namespace command
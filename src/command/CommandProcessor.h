@@ -1,18 +1,56 @@
 #pragma once
 
 #include "Codec.h"
+#include "CommandHelpers.h"
 #include "KeyValueStore.h"
+#include "StringHash.h"
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace command {
 
+// Whose watches: any nonzero id the caller keeps unique per client
+using WatcherId = uint64_t;
+
 class CommandProcessor {
 public:
     CommandProcessor(storage::KeyValueStore& kvStore);
 
-    codec::CodecValue process(const codec::CodecValue& msg) const;
+    codec::CodecValue process(const codec::CodecValue& msg);
+    // Runs a request already split into arguments, command name first
+    codec::CodecValue execute(CommandArgs args);
+    // The error for a request that can't run: an unknown command or the
+    // wrong number of arguments
+    static std::optional<codec::CodecValue> check(CommandArgs args);
+
+    // Optimistic locking for MULTI/EXEC. Any write command naming a
+    // watched key afterwards spoils the watcher's next exec, whether or
+    // not it changed anything.
+    void watch(WatcherId watcher, CommandArgs keys);
+    void unwatch(WatcherId watcher);
+    // Runs requests back to back, their arguments laid end to end and
+    // counted by requests, replying with an array of their replies; or
+    // with a null, running nothing, if a watched key was written. Either
+    // way the watcher's keys are released.
+    codec::CodecValue exec(WatcherId watcher, CommandArgs args, std::span<const size_t> requests);
 
 private:
+    void touch(std::string_view key);
+
+    struct Watch {
+        std::vector<std::string> keys;
+        bool spoiled = false;
+    };
+
     storage::KeyValueStore& kvStore_;
+    // Who watches each key, and what each watcher watches
+    std::unordered_map<std::string, std::vector<WatcherId>, storage::StringHash, std::equal_to<>> watchers_;
+    std::unordered_map<WatcherId, Watch> watches_;
 };
 
-} // namespace command
\ No newline at end of file
+} // namespace command
@@ -0,0 +1,139 @@
+#include "CommandTable.h"
+#include "HashCommands.h"
+#include "ListCommands.h"
+#include "SetCommands.h"
+#include "SortedSetCommands.h"
+#include "StringCommands.h"
+#include <array>
+
+namespace command {
+
+namespace {
+    using enum CommandSpec::Flags;
+
+    constexpr CommandSpec COMMANDS[] = {
+        // name, handler, arity, flags, first key, last key, key step[, key count]
+        { "SET", cmdSet, 3, Write, 1, 1, 1 },
+        { "GET", cmdGet, 2, Read, 1, 1, 1 },
+        { "DEL", cmdDel, -2, Write, 1, -1, 1 },
+        { "EXISTS", cmdExists, -2, Read, 1, -1, 1 },
+        { "MGET", cmdMGet, -2, Read, 1, -1, 1 },
+        { "MSET", cmdMSet, -3, Write, 1, -1, 2 },
+        { "INCR", cmdIncr, 2, Write, 1, 1, 1 },
+        { "DECR", cmdDecr, 2, Write, 1, 1, 1 },
+        { "INCRBY", cmdIncrBy, 3, Write, 1, 1, 1 },
+        { "DECRBY", cmdDecrBy, 3, Write, 1, 1, 1 },
+        { "INCRBYFLOAT", cmdIncrByFloat, 3, Write, 1, 1, 1 },
+        { "APPEND", cmdAppend, 3, Write, 1, 1, 1 },
+        { "STRLEN", cmdStrLen, 2, Read, 1, 1, 1 },
+        { "OBJECT", cmdObject, -2, Read, 2, 2, 1 },
+        { "LPUSH", cmdLPush, -3, Write, 1, 1, 1 },
+        { "RPUSH", cmdRPush, -3, Write, 1, 1, 1 },
+        { "LPOP", cmdLPop, -2, Write, 1, 1, 1 },
+        { "RPOP", cmdRPop, -2, Write, 1, 1, 1 },
+        { "LRANGE", cmdLRange, 4, Read, 1, 1, 1 },
+        { "SADD", cmdSAdd, -3, Write, 1, 1, 1 },
+        { "SREM", cmdSRem, -3, Write, 1, 1, 1 },
+        { "SISMEMBER", cmdSIsMember, 3, Read, 1, 1, 1 },
+        { "SMEMBERS", cmdSMembers, 2, Read, 1, 1, 1 },
+        { "SINTER", cmdSInter, -2, Read, 1, -1, 1 },
+        { "SUNION", cmdSUnion, -2, Read, 1, -1, 1 },
+        { "SDIFF", cmdSDiff, -2, Read, 1, -1, 1 },
+        { "SINTERCARD", cmdSInterCard, -3, Read, 0, 0, 0, 1 },
+        { "SINTERSTORE", cmdSInterStore, -3, Write, 1, -1, 1 },
+        { "SUNIONSTORE", cmdSUnionStore, -3, Write, 1, -1, 1 },
+        { "SDIFFSTORE", cmdSDiffStore, -3, Write, 1, -1, 1 },
+        { "HSET", cmdHSet, -4, Write, 1, 1, 1 },
+        { "HGET", cmdHGet, 3, Read, 1, 1, 1 },
+        { "HDEL", cmdHDel, -3, Write, 1, 1, 1 },
+        { "HMGET", cmdHMGet, -3, Read, 1, 1, 1 },
+        { "HGETALL", cmdHGetAll, 2, Read, 1, 1, 1 },
+        { "ZADD", cmdZAdd, -4, Write, 1, 1, 1 },
+        { "ZREM", cmdZRem, -3, Write, 1, 1, 1 },
+        { "ZRANGE", cmdZRange, -4, Read, 1, 1, 1 },
+        { "ZREVRANGE", cmdZRevRange, -4, Read, 1, 1, 1 },
+        { "ZRANGEBYSCORE", cmdZRangeByScore, -4, Read, 1, 1, 1 },
+        { "ZCOUNT", cmdZCount, 4, Read, 1, 1, 1 },
+        { "ZSCORE", cmdZScore, 3, Read, 1, 1, 1 },
+        { "ZRANK", cmdZRank, 3, Read, 1, 1, 1 },
+        { "ZREVRANK", cmdZRevRank, 3, Read, 1, 1, 1 },
+        { "ZINCRBY", cmdZIncrBy, 4, Write, 1, 1, 1 },
+        { "MULTI", nullptr, 1, Transaction, 0, 0, 0 },
+        { "EXEC", nullptr, 1, Transaction, 0, 0, 0 },
+        { "DISCARD", nullptr, 1, Transaction, 0, 0, 0 },
+        { "WATCH", nullptr, -2, Transaction, 1, -1, 1 },
+        { "UNWATCH", nullptr, 1, Transaction, 0, 0, 0 },
+    };
+    constexpr size_t COMMAND_COUNT = std::size(COMMANDS);
+
+    // Sparse enough that a collision-free seed turns up within a few hundred
+    // tries, even with several times as many commands
+    constexpr size_t TABLE_SIZE = 512;
+    static_assert(COMMAND_COUNT < 255, "slots hold a command index + 1 in a byte");
+
+    constexpr char asciiUpper(char c)
+    {
+        return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+
+    // FNV-1a over the upper-cased name, so any casing lands on the same slot
+    constexpr uint32_t hashName(std::string_view name, uint32_t seed)
+    {
+        uint32_t hash = seed;
+        for (char c : name) {
+            hash ^= static_cast<unsigned char>(asciiUpper(c));
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    struct PerfectHash {
+        uint32_t seed;
+        std::array<uint8_t, TABLE_SIZE> slots; // Command index + 1, 0 if empty
+    };
+
+    // Tries seeds until every command gets a slot of its own
+    constexpr PerfectHash buildPerfectHash()
+    {
+        for (uint32_t seed = 2166136261u;; ++seed) {
+            PerfectHash table { seed, {} };
+            bool collided = false;
+            for (size_t i = 0; i < COMMAND_COUNT && !collided; ++i) {
+                uint8_t& slot = table.slots[hashName(COMMANDS[i].name, seed) % TABLE_SIZE];
+                collided = slot != 0;
+                slot = static_cast<uint8_t>(i + 1);
+            }
+            if (!collided)
+                return table;
+        }
+    }
+
+    constexpr PerfectHash PERFECT_HASH = buildPerfectHash();
+
+    bool equalsIgnoreCase(std::string_view upper, std::string_view name)
+    {
+        if (upper.size() != name.size())
+            return false;
+        for (size_t i = 0; i < name.size(); ++i) {
+            if (asciiUpper(name[i]) != upper[i])
+                return false;
+        }
+        return true;
+    }
+} // namespace
+
+const CommandSpec* findCommand(std::string_view name)
+{
+    uint8_t slot = PERFECT_HASH.slots[hashName(name, PERFECT_HASH.seed) % TABLE_SIZE];
+    if (slot == 0)
+        return nullptr;
+    const CommandSpec& spec = COMMANDS[slot - 1];
+    return equalsIgnoreCase(spec.name, name) ? &spec : nullptr;
+}
+
+std::span<const CommandSpec> allCommands()
+{
+    return COMMANDS;
+}
+
+} // namespace command
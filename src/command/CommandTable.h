@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Codec.h"
+#include "CommandHelpers.h"
+#include "KeyValueStore.h"
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace command {
+
+using CommandHandler = codec::CodecValue (*)(storage::KeyValueStore&, CommandArgs);
+
+// What the server knows about a command before running it. Arity and key
+// positions follow Redis: arity counts the command name, and a negative
+// arity -N means at least N arguments. Keys are at firstKey, firstKey +
+// keyStep, ... up to lastKey, where a negative lastKey counts from the end.
+// A command whose keys follow a count of them, like SINTERCARD numkeys
+// key..., gives the count's position as keyCountArg instead.
+struct CommandSpec {
+    enum Flags : uint8_t {
+        Read = 1 << 0, // Reads the keyspace
+        Write = 1 << 1, // May modify the keyspace
+        Transaction = 1 << 2 // MULTI and its kin: the connection runs them, not a handler
+    };
+
+    std::string_view name; // Upper case
+    CommandHandler handler; // Only called with an argument count arity accepts; null for Transaction commands
+    int arity;
+    uint8_t flags;
+    int firstKey; // 0 if the command takes no keys
+    int lastKey;
+    int keyStep;
+    int keyCountArg = 0; // 0 if the command has no key count
+
+    bool has(Flags flag) const { return flags & flag; }
+    bool acceptsArgCount(size_t count) const
+    {
+        return arity >= 0 ? count == static_cast<size_t>(arity) : count >= static_cast<size_t>(-arity);
+    }
+};
+
+// Case-insensitive lookup through a perfect hash built at compile time; no
+// allocation. Returns nullptr for unknown commands.
+const CommandSpec* findCommand(std::string_view name);
+std::span<const CommandSpec> allCommands();
+
+// Calls fn with each argument the request names as a key
+template <typename Fn>
+void forEachKey(const CommandSpec& spec, CommandArgs args, Fn fn)
+{
+    if (spec.keyCountArg > 0) {
+        // A bad count names no keys; the handler rejects it
+        long long count;
+        size_t countAt = static_cast<size_t>(spec.keyCountArg);
+        if (countAt >= args.size() || !parseInteger(args[countAt], count) || count < 0)
+            return;
+        for (size_t i = countAt + 1; i <= countAt + static_cast<size_t>(count) && i < args.size(); ++i)
+            fn(args[i]);
+        return;
+    }
+    if (spec.firstKey <= 0)
+        return;
+    long last = spec.lastKey < 0 ? static_cast<long>(args.size()) + spec.lastKey : spec.lastKey;
+    for (long i = spec.firstKey; i <= last && i < static_cast<long>(args.size()); i += spec.keyStep)
+        fn(args[i]);
+}
+
+} // namespace command
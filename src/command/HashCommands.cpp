@@ -5,65 +5,49 @@
 namespace command {
 
 // Hash commands
-codec::CodecValue cmdHSet(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdHSet(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 4)
+    if (args.size() % 2 != 0)
         return codec::err("ERR wrong number of arguments for 'hset' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string field = extractBulkString(args[2]);
-        std::string value = extractBulkString(args[3]);
-        bool added = store.hset(key, field, value);
-        return codec::integer(added ? 1 : 0);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
-    }
+    return codec::integer(store.hset(args[1], args.subspan(2)));
 }
 
-codec::CodecValue cmdHGet(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdHGet(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 3)
-        return codec::err("ERR wrong number of arguments for 'hget' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string field = extractBulkString(args[2]);
-        std::string value = store.hget(key, field);
-        return codec::bulk(value);
-    } catch (const std::exception&) {
-        return codec::nullBulk();
-    }
+    auto value = store.hget(args[1], args[2]);
+    if (!value)
+        return storeError(value.error(), codec::nullBulk());
+    return codec::bulk(std::move(*value));
 }
 
-codec::CodecValue cmdHDel(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdHDel(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 3)
-        return codec::err("ERR wrong number of arguments for 'hdel' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string field = extractBulkString(args[2]);
-        bool deleted = store.hdel(key, field);
-        return codec::integer(deleted ? 1 : 0);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
-    }
+    auto deleted = store.hdel(args[1], args.subspan(2));
+    if (!deleted)
+        return storeError(deleted.error(), codec::integer(0));
+    return codec::integer(*deleted);
+}
+
+codec::CodecValue cmdHMGet(storage::KeyValueStore& store, CommandArgs args)
+{
+    auto values = store.hmget(args[1], args.subspan(2));
+    if (!values)
+        return storeError(values.error(), codec::array({}));
+    return bulkArray(std::move(*values));
 }
 
-codec::CodecValue cmdHGetAll(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdHGetAll(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 2)
-        return codec::err("ERR wrong number of arguments for 'hgetall' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        auto hash = store.hgetall(key);
-        std::vector<codec::CodecValue> values;
-        for (const auto& [field, value] : hash) {
-            values.push_back(codec::bulk(field));
-            values.push_back(codec::bulk(value));
-        }
-        return codec::array(values);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
+    auto hash = store.hgetall(args[1]);
+    if (!hash)
+        return storeError(hash.error(), codec::array({}));
+    std::vector<codec::CodecValue> values;
+    values.reserve(hash->size() * 2);
+    for (auto& [field, value] : *hash) {
+        values.push_back(codec::bulk(std::move(field)));
+        values.push_back(codec::bulk(std::move(value)));
     }
+    return codec::array(std::move(values));
 }
 
 }
\ No newline at end of file
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "Codec.h"
+#include "CommandHelpers.h"
 #include "KeyValueStore.h"
 
 namespace command {
-codec::CodecValue cmdHSet(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdHGet(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdHDel(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdHGetAll(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
+codec::CodecValue cmdHSet(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdHGet(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdHDel(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdHMGet(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdHGetAll(storage::KeyValueStore& store, CommandArgs args);
 }
\ No newline at end of file
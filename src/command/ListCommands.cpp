@@ -2,76 +2,70 @@
 #include "CommandHelpers.h"
 
 namespace command {
-codec::CodecValue cmdLPush(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
-{
-    if (args.size() != 3)
-        return codec::err("ERR wrong number of arguments for 'lpush' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string value = extractBulkString(args[2]);
-        size_t len = store.lpush(key, value);
-        return codec::integer(len);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
+namespace {
+    // LPOP and RPOP: key [count]. Without a count the reply is the value
+    // itself; with one it's an array, or a null array for a missing key.
+    codec::CodecValue pop(storage::KeyValueStore& store, CommandArgs args, bool front)
+    {
+        if (args.size() > 3)
+            return codec::err("ERR wrong number of arguments for '" + toLower(args[0]) + "' command");
+        if (args.size() == 2) {
+            auto value = front ? store.lpop(args[1]) : store.rpop(args[1]);
+            if (!value)
+                return storeError(value.error(), codec::nullBulk());
+            return codec::bulk(std::move(*value));
+        }
+        long long count;
+        if (!parseInteger(args[2], count))
+            return notIntegerError();
+        if (count < 0)
+            return codec::err("ERR value is out of range, must be positive");
+        auto popped = front ? store.lpop(args[1], count) : store.rpop(args[1], count);
+        if (!popped)
+            return storeError(popped.error(), codec::nullArray());
+        std::vector<codec::CodecValue> values;
+        values.reserve(popped->size());
+        for (std::string& s : *popped)
+            values.push_back(codec::bulk(std::move(s)));
+        return codec::array(std::move(values));
     }
+} // namespace
+
+codec::CodecValue cmdLPush(storage::KeyValueStore& store, CommandArgs args)
+{
+    size_t len = store.lpush(args[1], args.subspan(2));
+    return codec::integer(len);
 }
 
-codec::CodecValue cmdRPush(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdRPush(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 3)
-        return codec::err("ERR wrong number of arguments for 'rpush' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string value = extractBulkString(args[2]);
-        size_t len = store.rpush(key, value);
-        return codec::integer(len);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
-    }
+    size_t len = store.rpush(args[1], args.subspan(2));
+    return codec::integer(len);
 }
 
-codec::CodecValue cmdLPop(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdLPop(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 2)
-        return codec::err("ERR wrong number of arguments for 'lpop' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string value = store.lpop(key);
-        return codec::bulk(value);
-    } catch (const std::exception&) {
-        return codec::nullBulk();
-    }
+    return pop(store, args, true);
 }
 
-codec::CodecValue cmdRPop(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdRPop(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 2)
-        return codec::err("ERR wrong number of arguments for 'rpop' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string value = store.rpop(key);
-        return codec::bulk(value);
-    } catch (const std::exception&) {
-        return codec::nullBulk();
-    }
+    return pop(store, args, false);
 }
 
-codec::CodecValue cmdLRange(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdLRange(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 4)
-        return codec::err("ERR wrong number of arguments for 'lrange' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        int start = parseInteger(extractBulkString(args[2]));
-        int stop = parseInteger(extractBulkString(args[3]));
-        std::vector<std::string> result = store.lrange(key, start, stop);
-        std::vector<codec::CodecValue> values;
-        for (const auto& s : result) {
-            values.push_back(codec::bulk(s));
-        }
-        return codec::array(values);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
+    long long start, stop;
+    if (!parseInteger(args[2], start) || !parseInteger(args[3], stop))
+        return notIntegerError();
+    auto result = store.lrange(args[1], start, stop);
+    if (!result)
+        return storeError(result.error(), codec::array({}));
+    std::vector<codec::CodecValue> values;
+    values.reserve(result->size());
+    for (std::string& s : *result) {
+        values.push_back(codec::bulk(std::move(s)));
     }
+    return codec::array(std::move(values));
 }
 } // namespace command
@@ -1,13 +1,14 @@
 #pragma once
 
 #include "Codec.h"
+#include "CommandHelpers.h"
 #include "KeyValueStore.h"
 
 namespace command {
 
-codec::CodecValue cmdLPush(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdRPush(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdLPop(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdRPop(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdLRange(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
+codec::CodecValue cmdLPush(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdRPush(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdLPop(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdRPop(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdLRange(storage::KeyValueStore& store, CommandArgs args);
 }
\ No newline at end of file
@@ -2,48 +2,101 @@
 #include "CommandHelpers.h"
 
 namespace command {
-codec::CodecValue cmdSAdd(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
-{
-    if (args.size() != 3)
-        return codec::err("ERR wrong number of arguments for 'sadd' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string member = extractBulkString(args[2]);
-        size_t added = store.sadd(key, member);
-        return codec::integer(added);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
+namespace {
+    codec::CodecValue membersReply(storage::Result<std::vector<std::string>> members)
+    {
+        if (!members)
+            return storeError(members.error(), codec::array({}));
+        std::vector<codec::CodecValue> values;
+        values.reserve(members->size());
+        for (auto& m : *members) {
+            values.push_back(codec::bulk(std::move(m)));
+        }
+        return codec::array(std::move(values));
     }
+
+    codec::CodecValue cardinalityReply(storage::Result<size_t> size)
+    {
+        if (!size)
+            return storeError(size.error(), codec::integer(0));
+        return codec::integer(*size);
+    }
+} // namespace
+
+codec::CodecValue cmdSAdd(storage::KeyValueStore& store, CommandArgs args)
+{
+    size_t added = store.sadd(args[1], args.subspan(2));
+    return codec::integer(added);
 }
 
-codec::CodecValue cmdSRem(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdSRem(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 3)
-        return codec::err("ERR wrong number of arguments for 'srem' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string member = extractBulkString(args[2]);
-        size_t removed = store.srem(key, member);
-        return codec::integer(removed);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
-    }
+    auto removed = store.srem(args[1], args.subspan(2));
+    if (!removed)
+        return storeError(removed.error(), codec::integer(0));
+    return codec::integer(*removed);
 }
 
-codec::CodecValue cmdSMembers(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdSIsMember(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 2)
-        return codec::err("ERR wrong number of arguments for 'smembers' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        auto members = store.smembers(key);
-        std::vector<codec::CodecValue> values;
-        for (const auto& m : members) {
-            values.push_back(codec::bulk(m));
-        }
-        return codec::array(values);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
+    auto found = store.sismember(args[1], args[2]);
+    if (!found)
+        return storeError(found.error(), codec::integer(0));
+    return codec::integer(*found ? 1 : 0);
+}
+
+codec::CodecValue cmdSMembers(storage::KeyValueStore& store, CommandArgs args)
+{
+    return membersReply(store.smembers(args[1]));
+}
+
+codec::CodecValue cmdSInter(storage::KeyValueStore& store, CommandArgs args)
+{
+    return membersReply(store.sinter(args.subspan(1)));
+}
+
+codec::CodecValue cmdSUnion(storage::KeyValueStore& store, CommandArgs args)
+{
+    return membersReply(store.sunion(args.subspan(1)));
+}
+
+codec::CodecValue cmdSDiff(storage::KeyValueStore& store, CommandArgs args)
+{
+    return membersReply(store.sdiff(args.subspan(1)));
+}
+
+// SINTERCARD numkeys key [key ...] [LIMIT limit]
+codec::CodecValue cmdSInterCard(storage::KeyValueStore& store, CommandArgs args)
+{
+    long long numKeys;
+    if (!parseInteger(args[1], numKeys) || numKeys <= 0)
+        return codec::err("ERR numkeys should be greater than 0");
+    if (static_cast<unsigned long long>(numKeys) > args.size() - 2)
+        return codec::err("ERR Number of keys can't be greater than number of args");
+    size_t limit = SIZE_MAX;
+    for (size_t i = 2 + numKeys; i < args.size(); i += 2) {
+        if (toUpper(args[i]) != "LIMIT" || i + 1 == args.size())
+            return syntaxError();
+        long long value;
+        if (!parseInteger(args[i + 1], value) || value < 0)
+            return codec::err("ERR LIMIT can't be negative");
+        limit = value == 0 ? SIZE_MAX : static_cast<size_t>(value);
     }
+    return cardinalityReply(store.sintercard(args.subspan(2, numKeys), limit));
+}
+
+codec::CodecValue cmdSInterStore(storage::KeyValueStore& store, CommandArgs args)
+{
+    return cardinalityReply(store.sinterstore(args[1], args.subspan(2)));
+}
+
+codec::CodecValue cmdSUnionStore(storage::KeyValueStore& store, CommandArgs args)
+{
+    return cardinalityReply(store.sunionstore(args[1], args.subspan(2)));
+}
+
+codec::CodecValue cmdSDiffStore(storage::KeyValueStore& store, CommandArgs args)
+{
+    return cardinalityReply(store.sdiffstore(args[1], args.subspan(2)));
 }
 }
\ No newline at end of file
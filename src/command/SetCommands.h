@@ -1,10 +1,19 @@
 #pragma once
 
 #include "Codec.h"
+#include "CommandHelpers.h"
 #include "KeyValueStore.h"
 
 namespace command {
-codec::CodecValue cmdSAdd(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdSRem(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdSMembers(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
+codec::CodecValue cmdSAdd(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSRem(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSIsMember(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSMembers(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSInter(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSUnion(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSDiff(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSInterCard(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSInterStore(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSUnionStore(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdSDiffStore(storage::KeyValueStore& store, CommandArgs args);
 }
\ No newline at end of file
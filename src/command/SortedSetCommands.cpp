@@ -2,51 +2,173 @@
 #include "CommandHelpers.h"
 
 namespace command {
-codec::CodecValue cmdZAdd(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+namespace {
+    bool equalsIgnoreCase(std::string_view arg, std::string_view upper)
+    {
+        return toUpper(arg) == upper;
+    }
+
+    // A ZRANGEBYSCORE or ZCOUNT bound: a score, "-inf" or "+inf", with a
+    // leading '(' to leave the score itself out
+    bool parseScoreBound(std::string_view str, double& score, bool& exclusive)
+    {
+        exclusive = !str.empty() && str.front() == '(';
+        if (exclusive)
+            str.remove_prefix(1);
+        return parseDouble(str, score);
+    }
+
+    bool parseScoreRange(CommandArgs args, storage::ScoreRange& range)
+    {
+        return parseScoreBound(args[2], range.min, range.minExclusive)
+            && parseScoreBound(args[3], range.max, range.maxExclusive);
+    }
+
+    codec::CodecValue scoreRangeError()
+    {
+        return codec::err("ERR min or max is not a float");
+    }
+
+    codec::CodecValue scoredReply(std::vector<storage::ScoredMember>& entries, bool withScores)
+    {
+        std::vector<codec::CodecValue> values;
+        values.reserve(withScores ? entries.size() * 2 : entries.size());
+        for (auto& entry : entries) {
+            values.push_back(codec::bulk(std::move(entry.member)));
+            if (withScores)
+                values.push_back(codec::bulk(formatDouble(entry.score)));
+        }
+        return codec::array(std::move(values));
+    }
+
+    // ZRANGE and ZREVRANGE: key start stop [WITHSCORES]
+    codec::CodecValue rangeByRank(storage::KeyValueStore& store, CommandArgs args, bool reverse)
+    {
+        bool withScores = args.size() == 5 && equalsIgnoreCase(args[4], "WITHSCORES");
+        if (args.size() > 4 && !withScores)
+            return syntaxError();
+        long long start, stop;
+        if (!parseInteger(args[2], start) || !parseInteger(args[3], stop))
+            return notIntegerError();
+        auto result = store.zrange(args[1], start, stop, reverse);
+        if (!result)
+            return storeError(result.error(), codec::array({}));
+        return scoredReply(*result, withScores);
+    }
+
+    codec::CodecValue rank(storage::KeyValueStore& store, CommandArgs args, bool reverse)
+    {
+        auto rank = store.zrank(args[1], args[2], reverse);
+        if (!rank)
+            return storeError(rank.error(), codec::nullBulk());
+        return codec::integer(*rank);
+    }
+} // namespace
+
+// ZADD key score member [score member ...]
+codec::CodecValue cmdZAdd(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 4)
-        return codec::err("ERR wrong number of arguments for 'zadd' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        double score = parseDouble(extractBulkString(args[2]));
-        std::string member = extractBulkString(args[3]);
-        size_t added = store.zadd(key, score, member);
-        return codec::integer(added);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
+    if (args.size() % 2 != 0)
+        return syntaxError();
+    // Every score is checked before anything is added
+    std::vector<std::pair<double, std::string_view>> entries;
+    entries.reserve((args.size() - 2) / 2);
+    for (size_t i = 2; i < args.size(); i += 2) {
+        double score;
+        if (!parseDouble(args[i], score))
+            return notFloatError();
+        entries.emplace_back(score, args[i + 1]);
     }
+    size_t added = store.zadd(args[1], entries);
+    return codec::integer(added);
 }
 
-codec::CodecValue cmdZRem(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdZRem(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 3)
-        return codec::err("ERR wrong number of arguments for 'zrem' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string member = extractBulkString(args[2]);
-        size_t removed = store.zrem(key, member);
-        return codec::integer(removed);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
-    }
+    auto removed = store.zrem(args[1], args.subspan(2));
+    if (!removed)
+        return storeError(removed.error(), codec::integer(0));
+    return codec::integer(*removed);
 }
 
-codec::CodecValue cmdZRange(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdZRange(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 4)
-        return codec::err("ERR wrong number of arguments for 'zrange' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        int start = parseInteger(extractBulkString(args[2]));
-        int stop = parseInteger(extractBulkString(args[3]));
-        std::vector<std::string> result = store.zrange(key, start, stop);
-        std::vector<codec::CodecValue> values;
-        for (const auto& s : result) {
-            values.push_back(codec::bulk(s));
+    return rangeByRank(store, args, false);
+}
+
+codec::CodecValue cmdZRevRange(storage::KeyValueStore& store, CommandArgs args)
+{
+    return rangeByRank(store, args, true);
+}
+
+// ZRANGEBYSCORE key min max [WITHSCORES] [LIMIT offset count]
+codec::CodecValue cmdZRangeByScore(storage::KeyValueStore& store, CommandArgs args)
+{
+    storage::ScoreRange range;
+    if (!parseScoreRange(args, range))
+        return scoreRangeError();
+
+    bool withScores = false;
+    long long offset = 0, count = -1;
+    for (size_t i = 4; i < args.size(); ++i) {
+        if (equalsIgnoreCase(args[i], "WITHSCORES")) {
+            withScores = true;
+        } else if (equalsIgnoreCase(args[i], "LIMIT") && i + 2 < args.size()) {
+            if (!parseInteger(args[i + 1], offset) || !parseInteger(args[i + 2], count))
+                return notIntegerError();
+            i += 2;
+        } else {
+            return syntaxError();
         }
-        return codec::array(values);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
     }
+    // As in Redis, a negative offset matches nothing and a negative count
+    // means no limit
+    if (offset < 0)
+        return codec::array({});
+
+    auto result = store.zrangebyscore(args[1], range, offset, count < 0 ? SIZE_MAX : static_cast<size_t>(count));
+    if (!result)
+        return storeError(result.error(), codec::array({}));
+    return scoredReply(*result, withScores);
+}
+
+codec::CodecValue cmdZCount(storage::KeyValueStore& store, CommandArgs args)
+{
+    storage::ScoreRange range;
+    if (!parseScoreRange(args, range))
+        return scoreRangeError();
+    auto count = store.zcount(args[1], range);
+    if (!count)
+        return storeError(count.error(), codec::integer(0));
+    return codec::integer(*count);
+}
+
+codec::CodecValue cmdZScore(storage::KeyValueStore& store, CommandArgs args)
+{
+    auto score = store.zscore(args[1], args[2]);
+    if (!score)
+        return storeError(score.error(), codec::nullBulk());
+    return codec::bulk(formatDouble(*score));
+}
+
+codec::CodecValue cmdZRank(storage::KeyValueStore& store, CommandArgs args)
+{
+    return rank(store, args, false);
+}
+
+codec::CodecValue cmdZRevRank(storage::KeyValueStore& store, CommandArgs args)
+{
+    return rank(store, args, true);
+}
+
+codec::CodecValue cmdZIncrBy(storage::KeyValueStore& store, CommandArgs args)
+{
+    double delta;
+    if (!parseDouble(args[2], delta))
+        return notFloatError();
+    auto score = store.zincrby(args[1], delta, args[3]);
+    if (!score)
+        return storeError(score.error(), codec::err("ERR resulting score is not a number (NaN)"));
+    return codec::bulk(formatDouble(*score));
 }
 }
\ No newline at end of file
@@ -1,10 +1,18 @@
 #pragma once
 
 #include "Codec.h"
+#include "CommandHelpers.h"
 #include "KeyValueStore.h"
 
 namespace command {
-codec::CodecValue cmdZAdd(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdZRem(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdZRange(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
+codec::CodecValue cmdZAdd(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdZRem(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdZRange(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdZRevRange(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdZRangeByScore(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdZCount(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdZScore(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdZRank(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdZRevRank(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdZIncrBy(storage::KeyValueStore& store, CommandArgs args);
 }
\ No newline at end of file
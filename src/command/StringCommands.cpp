@@ -4,57 +4,126 @@
 #include "Codec.h"
 #include "KeyValueStore.h"
 
+#include <climits>
+
 namespace command {
-codec::CodecValue cmdSet(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
-{
-    if (args.size() != 3)
-        return codec::err("ERR wrong number of arguments for 'set' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string value = extractBulkString(args[2]);
-        store.set(key, value);
-        return codec::ok();
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
+namespace {
+    codec::CodecValue incrementBy(storage::KeyValueStore& store, std::string_view key, long long delta)
+    {
+        auto value = store.incrby(key, delta);
+        if (value)
+            return codec::integer(*value);
+        if (value.error() == storage::StoreError::OutOfRange)
+            return codec::err("ERR increment or decrement would overflow");
+        return storeError(value.error(), notIntegerError());
     }
+} // namespace
+
+codec::CodecValue cmdSet(storage::KeyValueStore& store, CommandArgs args)
+{
+    store.set(args[1], args[2]);
+    return codec::ok();
 }
 
-codec::CodecValue cmdGet(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdGet(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 2)
-        return codec::err("ERR wrong number of arguments for 'get' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        std::string value = store.get(key);
-        return codec::bulk(value);
-    } catch (const std::exception&) {
-        return codec::nullBulk();
-    }
+    auto value = store.get(args[1]);
+    if (!value)
+        return storeError(value.error(), codec::nullBulk());
+    return codec::bulk(std::move(*value));
 }
 
-codec::CodecValue cmdDel(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdDel(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 2)
-        return codec::err("ERR wrong number of arguments for 'del' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        bool deleted = store.del(key);
-        return codec::integer(deleted ? 1 : 0);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
-    }
+    return codec::integer(store.del(args.subspan(1)));
 }
 
-codec::CodecValue cmdExists(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args)
+codec::CodecValue cmdExists(storage::KeyValueStore& store, CommandArgs args)
 {
-    if (args.size() != 2)
-        return codec::err("ERR wrong number of arguments for 'exists' command");
-    try {
-        std::string key = extractBulkString(args[1]);
-        bool exists = store.exists(key);
-        return codec::integer(exists ? 1 : 0);
-    } catch (const std::exception& e) {
-        return codec::err(std::string("ERR ") + e.what());
-    }
+    return codec::integer(store.exists(args.subspan(1)));
+}
+
+codec::CodecValue cmdMGet(storage::KeyValueStore& store, CommandArgs args)
+{
+    return bulkArray(store.mget(args.subspan(1)));
+}
+
+codec::CodecValue cmdMSet(storage::KeyValueStore& store, CommandArgs args)
+{
+    if (args.size() % 2 == 0)
+        return codec::err("ERR wrong number of arguments for 'mset' command");
+    store.mset(args.subspan(1));
+    return codec::ok();
+}
+
+codec::CodecValue cmdIncr(storage::KeyValueStore& store, CommandArgs args)
+{
+    return incrementBy(store, args[1], 1);
+}
+
+codec::CodecValue cmdDecr(storage::KeyValueStore& store, CommandArgs args)
+{
+    return incrementBy(store, args[1], -1);
+}
+
+codec::CodecValue cmdIncrBy(storage::KeyValueStore& store, CommandArgs args)
+{
+    long long delta;
+    if (!parseInteger(args[2], delta))
+        return notIntegerError();
+    return incrementBy(store, args[1], delta);
+}
+
+codec::CodecValue cmdDecrBy(storage::KeyValueStore& store, CommandArgs args)
+{
+    long long delta;
+    if (!parseInteger(args[2], delta))
+        return notIntegerError();
+    if (delta == LLONG_MIN)
+        return codec::err("ERR decrement would overflow");
+    return incrementBy(store, args[1], -delta);
+}
+
+codec::CodecValue cmdIncrByFloat(storage::KeyValueStore& store, CommandArgs args)
+{
+    long double delta;
+    if (!parseDouble(args[2], delta))
+        return notFloatError();
+    auto value = store.incrbyfloat(args[1], delta);
+    if (value)
+        return codec::bulk(std::move(*value));
+    if (value.error() == storage::StoreError::OutOfRange)
+        return codec::err("ERR increment would produce NaN or Infinity");
+    return storeError(value.error(), notFloatError());
+}
+
+codec::CodecValue cmdAppend(storage::KeyValueStore& store, CommandArgs args)
+{
+    auto length = store.append(args[1], args[2]);
+    if (!length)
+        return storeError(length.error(), codec::integer(0));
+    return codec::integer(*length);
+}
+
+codec::CodecValue cmdStrLen(storage::KeyValueStore& store, CommandArgs args)
+{
+    auto length = store.strlen(args[1]);
+    if (!length)
+        return storeError(length.error(), codec::integer(0));
+    return codec::integer(*length);
+}
+
+// OBJECT ENCODING key
+codec::CodecValue cmdObject(storage::KeyValueStore& store, CommandArgs args)
+{
+    std::string subcommand = toUpper(args[1]);
+    if (subcommand != "ENCODING")
+        return codec::err("ERR unknown subcommand '" + std::string(args[1]) + "'. Try OBJECT HELP.");
+    if (args.size() != 3)
+        return codec::err("ERR wrong number of arguments for 'object|encoding' command");
+    auto encoding = store.encoding(args[2]);
+    if (!encoding)
+        return codec::nullBulk();
+    return codec::bulk(*encoding);
 }
 } // namespace command
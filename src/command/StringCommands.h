@@ -1,11 +1,22 @@
 #pragma once
 
 #include "Codec.h"
+#include "CommandHelpers.h"
 #include "KeyValueStore.h"
 
 namespace command {
-codec::CodecValue cmdSet(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdGet(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdDel(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
-codec::CodecValue cmdExists(storage::KeyValueStore& store, const std::vector<codec::CodecValue>& args);
+codec::CodecValue cmdSet(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdGet(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdDel(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdExists(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdMGet(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdMSet(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdIncr(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdDecr(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdIncrBy(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdDecrBy(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdIncrByFloat(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdAppend(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdStrLen(storage::KeyValueStore& store, CommandArgs args);
+codec::CodecValue cmdObject(storage::KeyValueStore& store, CommandArgs args);
 } // namespace command
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include "Transaction.h"
+#include "CommandProcessor.h"
+
+namespace command {
+
+codec::CodecValue Transaction::queue(CommandArgs args)
+{
+    if (auto error = CommandProcessor::check(args)) {
+        failed_ = true;
+        return std::move(*error);
+    }
+    args_.insert(args_.end(), args.begin(), args.end());
+    requests_.push_back(args.size());
+    return codec::CodecValue { codec::SimpleString { "QUEUED" } };
+}
+
+void Transaction::clear()
+{
+    args_.clear();
+    requests_.clear();
+    active_ = false;
+    failed_ = false;
+}
+
+std::vector<std::string_view> Transaction::args() const
+{
+    return std::vector<std::string_view>(args_.begin(), args_.end());
+}
+
+} // namespace command
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Codec.h"
+#include "CommandHelpers.h"
+#include <span>
+#include <string>
+#include <vector>
+
+namespace command {
+
+// A client's MULTI block. Requests are checked against the command table as
+// they're queued, so one that could never run fails the block before EXEC
+// instead of partway through it. Queued arguments are owned: the client's
+// buffer moves on between MULTI and EXEC.
+class Transaction {
+public:
+    bool active() const { return active_; }
+    bool failed() const { return failed_; }
+
+    void begin() { active_ = true; }
+    // QUEUED, or why the request can't run, which fails the block
+    codec::CodecValue queue(CommandArgs args);
+    // Fails the block for a reason the command table doesn't know of
+    void fail() { failed_ = true; }
+    // Ends the block, dropping anything queued
+    void clear();
+
+    // Every queued request's arguments, end to end, and how many each has
+    std::vector<std::string_view> args() const;
+    std::span<const size_t> requests() const { return requests_; }
+
+private:
+    std::vector<std::string> args_;
+    std::vector<size_t> requests_;
+    bool active_ = false;
+    bool failed_ = false;
+};
+
+} // namespace command
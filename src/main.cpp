@@ -2,6 +2,9 @@
 #include <iostream>
 #include <csignal>
 #include <atomic>
+#include <algorithm>
+#include <string>
+#include <thread>
 
 constexpr int DEFAULT_PORT = 6379;
 
@@ -17,18 +20,63 @@ void signalHandler(int signal) {
     }
 }
 
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [port] [--reactors N] [--io-threads N] [--io-backend epoll|io_uring]" << std::endl;
+    std::cerr << "  --reactors N    event loop threads, each owning a shard of the keyspace (0 = one per core)" << std::endl;
+    std::cerr << "  --io-threads N  helper threads per reactor for socket I/O and RESP codec work" << std::endl;
+    std::cerr << "  --io-backend B  event loop backend: epoll (default) or io_uring" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     int port = DEFAULT_PORT;
-    if (argc > 1) {
-        port = std::atoi(argv[1]);
-        if (port <= 0 || port > 65535) {
-            std::cerr << "Invalid port number: " << argv[1] << std::endl;
-            std::cerr << "Usage: " << argv[0] << " [port]" << std::endl;
+    size_t reactors = 1;
+    size_t ioThreads = 0;
+    server::EventLoop::Backend backend = server::EventLoop::Backend::Epoll;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--reactors" && i + 1 < argc) {
+            int count = std::atoi(argv[++i]);
+            if (count < 0 || (count == 0 && std::string(argv[i]) != "0")) {
+                std::cerr << "Invalid reactor count: " << argv[i] << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            reactors = count > 0 ? count : std::max(1u, std::thread::hardware_concurrency());
+        } else if (arg == "--io-threads" && i + 1 < argc) {
+            int count = std::atoi(argv[++i]);
+            if (count < 0 || (count == 0 && std::string(argv[i]) != "0")) {
+                std::cerr << "Invalid I/O thread count: " << argv[i] << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            ioThreads = count;
+        } else if (arg == "--io-backend" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "epoll") {
+                backend = server::EventLoop::Backend::Epoll;
+            } else if (name == "io_uring") {
+                backend = server::EventLoop::Backend::IoUring;
+            } else {
+                std::cerr << "Unknown I/O backend: " << name << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (i == 1 && arg[0] != '-') {
+            port = std::atoi(argv[1]);
+            if (port <= 0 || port > 65535) {
+                std::cerr << "Invalid port number: " << argv[1] << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            printUsage(argv[0]);
             return 1;
         }
     }
 
-    server::Server server(port);
+    server::Server server(port, reactors, ioThreads, backend);
     g_server.store(&server);
 
     std::signal(SIGINT, signalHandler);
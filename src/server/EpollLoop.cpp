@@ -0,0 +1,177 @@
+#include "EpollLoop.h"
+#include "Reactor.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+
+namespace server {
+
+constexpr int MAX_EVENTS = 64;
+constexpr int BUFFER_SIZE = 4096;
+
+EpollLoop::~EpollLoop() {
+    if (epollFd_ != -1) {
+        close(epollFd_);
+    }
+}
+
+bool EpollLoop::start(int listenFd, int wakeFd) {
+    listenFd_ = listenFd;
+    wakeFd_ = wakeFd;
+
+    epollFd_ = epoll_create1(0);
+    if (epollFd_ == -1) {
+        std::cerr << "Failed to create epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    for (int fd : {listenFd, wakeFd}) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            std::cerr << "Failed to add fd to epoll: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool EpollLoop::poll(std::vector<Event>& events, bool wait) {
+    epoll_event ready[MAX_EVENTS];
+
+    int nfds;
+    while ((nfds = epoll_wait(epollFd_, ready, MAX_EVENTS, wait ? -1 : 0)) == -1) {
+        if (errno != EINTR) {
+            std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    for (int i = 0; i < nfds; ++i) {
+        int fd = ready[i].data.fd;
+        if (fd == listenFd_) {
+            acceptAll(events);
+        } else if (fd == wakeFd_) {
+            uint64_t count;
+            while (read(wakeFd_, &count, sizeof(count)) > 0) {
+            }
+            events.push_back({Event::Kind::Wake, fd});
+        } else {
+            if (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                events.push_back({Event::Kind::Input, fd});
+            }
+            if (ready[i].events & EPOLLOUT) {
+                events.push_back({Event::Kind::Output, fd});
+            }
+        }
+    }
+
+    return true;
+}
+
+void EpollLoop::acceptAll(std::vector<Event>& events) {
+    while (true) {
+        sockaddr_in clientAddr{};
+        socklen_t clientLen = sizeof(clientAddr);
+        int clientFd = accept4(listenFd_, reinterpret_cast<sockaddr*>(&clientAddr), &clientLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (clientFd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "Accept failed: " << strerror(errno) << std::endl;
+            }
+            break;
+        }
+
+        events.push_back({Event::Kind::Accept, clientFd});
+    }
+}
+
+bool EpollLoop::watch(Connection& conn) {
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = conn.fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, conn.fd, &ev) == -1) {
+        std::cerr << "Failed to add client to epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void EpollLoop::unwatch(Connection& conn) {
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+}
+
+bool EpollLoop::receive(Connection& conn) {
+    char buffer[BUFFER_SIZE];
+
+    while (true) {
+        ssize_t n = read(conn.fd, buffer, sizeof(buffer));
+
+        if (n == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            } else if (errno != EINTR) {
+                return false;
+            }
+        } else if (n == 0) {
+            return false;
+        } else {
+            conn.decoder.feed(buffer, n);
+        }
+    }
+}
+
+bool EpollLoop::transmit(Connection& conn) {
+    while (conn.outputSent < conn.output.size()) {
+        ssize_t n = send(conn.fd, conn.output.data() + conn.outputSent, conn.output.size() - conn.outputSent, MSG_NOSIGNAL);
+
+        if (n == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else if (errno != EINTR) {
+                return false;
+            }
+        } else {
+            conn.outputSent += n;
+        }
+    }
+
+    if (conn.outputSent == conn.output.size()) {
+        conn.output.clear();
+        conn.outputSent = 0;
+    } else if (conn.outputSent >= conn.output.size() / 2) {
+        // Drop the written prefix so the buffer doesn't grow without bound
+        conn.output.erase(0, conn.outputSent);
+        conn.outputSent = 0;
+    }
+    return true;
+}
+
+// Only ask for EPOLLOUT while there is something left to write
+bool EpollLoop::settle(Connection& conn) {
+    bool pending = !conn.output.empty();
+    if (pending == conn.wantWrite) {
+        return true;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET | (pending ? uint32_t(EPOLLOUT) : 0u);
+    ev.data.fd = conn.fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_MOD, conn.fd, &ev) == -1) {
+        std::cerr << "Failed to update client in epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+    conn.wantWrite = pending;
+    return true;
+}
+
+bool EpollLoop::hasPendingOutput(const Connection& conn) const {
+    return !conn.output.empty();
+}
+
+} // namespace server
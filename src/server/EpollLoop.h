@@ -0,0 +1,29 @@
+#pragma once
+#include "EventLoop.h"
+
+namespace server {
+
+// Readiness-based loop: epoll tells us which sockets are ready and the
+// reactor's phases do the read/write syscalls themselves.
+class EpollLoop : public EventLoop {
+public:
+    ~EpollLoop() override;
+
+    bool start(int listenFd, int wakeFd) override;
+    bool poll(std::vector<Event>& events, bool wait) override;
+    bool watch(Connection& conn) override;
+    void unwatch(Connection& conn) override;
+    bool receive(Connection& conn) override;
+    bool transmit(Connection& conn) override;
+    bool settle(Connection& conn) override;
+    bool hasPendingOutput(const Connection& conn) const override;
+
+private:
+    void acceptAll(std::vector<Event>& events);
+
+    int epollFd_ = -1;
+    int listenFd_ = -1;
+    int wakeFd_ = -1;
+};
+
+} // namespace server
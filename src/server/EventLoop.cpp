@@ -0,0 +1,21 @@
+#include "EventLoop.h"
+#include "EpollLoop.h"
+#include "UringLoop.h"
+
+namespace server {
+
+std::unique_ptr<EventLoop> EventLoop::create(Backend backend) {
+    switch (backend) {
+    case Backend::IoUring:
+        return std::make_unique<UringLoop>();
+    case Backend::Epoll:
+    default:
+        return std::make_unique<EpollLoop>();
+    }
+}
+
+const char* EventLoop::name(Backend backend) {
+    return backend == Backend::IoUring ? "io_uring" : "epoll";
+}
+
+} // namespace server
@@ -0,0 +1,59 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace server {
+
+struct Connection;
+
+// The I/O mechanism under a Reactor. The reactor owns the sockets and the
+// protocol; the loop reports what happened to them and moves bytes between
+// the sockets and each Connection's decoder and output buffer.
+class EventLoop {
+public:
+    struct Event {
+        enum class Kind {
+            Accept, // fd is a newly accepted client
+            Wake, // The reactor's eventfd was signalled
+            Input, // The client has input, or has hung up
+            Output // The client can take more output
+        };
+
+        Kind kind;
+        int fd;
+    };
+
+    enum class Backend {
+        Epoll,
+        IoUring
+    };
+
+    virtual ~EventLoop() = default;
+
+    virtual bool start(int listenFd, int wakeFd) = 0;
+    // Submits queued work, then collects events. With wait, blocks until
+    // there's at least one; otherwise returns at once, maybe with none.
+    virtual bool poll(std::vector<Event>& events, bool wait) = 0;
+
+    virtual bool watch(Connection& conn) = 0;
+    // Called before the reactor closes the client's fd
+    virtual void unwatch(Connection& conn) = 0;
+
+    // May run on an I/O thread, touching only conn: move received bytes into
+    // the decoder. Returns false once the peer has gone away.
+    virtual bool receive(Connection& conn) = 0;
+    // May run on an I/O thread, touching only conn: push output towards the
+    // socket. Returns false on a write error.
+    virtual bool transmit(Connection& conn) = 0;
+    // Runs on the reactor thread after each batch. Returns false if the
+    // connection has to be closed.
+    virtual bool settle(Connection& conn) = 0;
+    // True while the loop still holds output the peer hasn't received
+    virtual bool hasPendingOutput(const Connection& conn) const = 0;
+
+    static std::unique_ptr<EventLoop> create(Backend backend);
+    static const char* name(Backend backend);
+};
+
+} // namespace server
@@ -0,0 +1,96 @@
+#include "IoThreadPool.h"
+#include <exception>
+
+namespace server {
+
+IoThreadPool::IoThreadPool(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() {
+            workerLoop();
+        });
+    }
+}
+
+IoThreadPool::~IoThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void IoThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    // Waking the pool costs more than a single connection's work
+    if (workers_.empty() || count < 2) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &fn;
+        jobSize_ = count;
+        next_.store(0, std::memory_order_relaxed);
+        active_ = workers_.size();
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    // Workers still hold fn, so a throw here must wait for them before it
+    // unwinds; they take no further indices once it has
+    std::exception_ptr error;
+    try {
+        runJob();
+    } catch (...) {
+        error = std::current_exception();
+        next_.store(count, std::memory_order_relaxed);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() {
+        return active_ == 0;
+    });
+    job_ = nullptr;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void IoThreadPool::workerLoop() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        wake_.wait(lock, [&]() {
+            return stopping_ || generation_ != seen;
+        });
+        if (stopping_) {
+            return;
+        }
+        seen = generation_;
+
+        lock.unlock();
+        runJob();
+        lock.lock();
+
+        if (--active_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
+
+// Threads claim indices one at a time so a slow connection doesn't hold up
+// a whole pre-assigned share of the batch
+void IoThreadPool::runJob() {
+    size_t i;
+    while ((i = next_.fetch_add(1, std::memory_order_relaxed)) < jobSize_) {
+        (*job_)(i);
+    }
+}
+
+} // namespace server
@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace server {
+
+// Helper threads that share a reactor's per-connection socket and codec work.
+// With zero threads every job simply runs on the calling thread.
+class IoThreadPool {
+public:
+    explicit IoThreadPool(size_t threads);
+    ~IoThreadPool();
+
+    IoThreadPool(const IoThreadPool&) = delete;
+    IoThreadPool& operator=(const IoThreadPool&) = delete;
+
+    // Calls fn(i) for every i in [0, count) across the pool and the calling
+    // thread, returning once all calls have finished. If a call on the
+    // calling thread throws, the rest are skipped and the exception is
+    // rethrown once the workers are done.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    void workerLoop();
+    void runJob();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    uint64_t generation_ = 0;
+    size_t active_ = 0; // Workers still inside the current job
+    bool stopping_ = false;
+    const std::function<void(size_t)>* job_ = nullptr;
+    size_t jobSize_ = 0;
+    std::atomic<size_t> next_{0};
+};
+
+} // namespace server
@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+
+namespace server {
+
+// Lock-free multi-producer, single-consumer queue of intrusive nodes. T must
+// have a `T* next` member. Producers push with one CAS; the consumer takes
+// everything posted so far with one exchange.
+template <typename T>
+class Mailbox {
+public:
+    // Pushes a chain linked newest-first through next, from newest to oldest.
+    // Returns true if the mailbox was empty, i.e. the consumer needs waking.
+    bool push(T* newest, T* oldest) {
+        T* head = head_.load(std::memory_order_relaxed);
+        do {
+            oldest->next = head;
+        } while (!head_.compare_exchange_weak(head, newest, std::memory_order_release, std::memory_order_relaxed));
+        return head == nullptr;
+    }
+
+    bool push(T* node) {
+        return push(node, node);
+    }
+
+    // Takes every queued node, returned oldest-first
+    T* drain() {
+        T* node = head_.exchange(nullptr, std::memory_order_acquire);
+        T* reversed = nullptr;
+        while (node) {
+            T* next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+        return reversed;
+    }
+
+private:
+    std::atomic<T*> head_{nullptr};
+};
+
+} // namespace server
@@ -0,0 +1,614 @@
+#include "Reactor.h"
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+
+namespace server {
+
+// Time an idle iteration may spend on a pending keyspace resize
+constexpr std::chrono::microseconds IDLE_REHASH_BUDGET{1000};
+
+namespace {
+    codec::CodecValue crossSlotError() {
+        return codec::err("CROSSSLOT Keys in request don't hash to the same slot");
+    }
+} // namespace
+
+Reactor::Reactor(size_t index, int port, size_t ioThreads, EventLoop::Backend backend)
+    : index_(index), port_(port), backend_(backend), socketFd_(-1), wakeFd_(-1) {
+    kvStore_ = std::make_unique<storage::KeyValueStore>();
+    processor_ = std::make_unique<command::CommandProcessor>(*kvStore_);
+    ioThreads_ = std::make_unique<IoThreadPool>(ioThreads);
+}
+
+Reactor::~Reactor() {
+    loop_.reset();
+    for (const auto& [fd, _] : clients_) {
+        close(fd);
+    }
+    clients_.clear();
+
+    // Envelopes still in flight when the loops stopped
+    for (Envelope* envelope = mailbox_.drain(); envelope;) {
+        Envelope* next = envelope->next;
+        delete envelope;
+        envelope = next;
+    }
+    for (Outbox& outbox : outboxes_) {
+        for (Envelope* envelope = outbox.newest; envelope;) {
+            Envelope* next = envelope->next;
+            delete envelope;
+            envelope = next;
+        }
+    }
+
+    for (int* fd : {&socketFd_, &wakeFd_}) {
+        if (*fd != -1) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+bool Reactor::start(bool reusePort) {
+    socketFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (socketFd_ == -1) {
+        std::cerr << "Failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    int opt = 1;
+    if (setsockopt(socketFd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) {
+        std::cerr << "Failed to set SO_REUSEADDR: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (reusePort && setsockopt(socketFd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) {
+        std::cerr << "Failed to set SO_REUSEPORT: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (!setNonBlocking(socketFd_)) {
+        return false;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port_);
+
+    if (bind(socketFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        std::cerr << "Failed to bind socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (listen(socketFd_, SOMAXCONN) == -1) {
+        std::cerr << "Failed to listen: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd_ == -1) {
+        std::cerr << "Failed to create eventfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    loop_ = EventLoop::create(backend_);
+    if (!loop_->start(socketFd_, wakeFd_)) {
+        if (backend_ == EventLoop::Backend::Epoll) {
+            return false;
+        }
+        std::cerr << "Falling back to epoll" << std::endl;
+        backend_ = EventLoop::Backend::Epoll;
+        loop_ = EventLoop::create(backend_);
+        if (!loop_->start(socketFd_, wakeFd_)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Reactor::setPeers(std::vector<Reactor*> peers) {
+    peers_ = std::move(peers);
+    outboxes_.assign(peers_.size(), Outbox {});
+}
+
+void Reactor::run() {
+    std::vector<EventLoop::Event> events;
+
+    while (!stopping_.load(std::memory_order_acquire)) {
+        events.clear();
+        // While the store has a resize to finish, don't block: iterations
+        // with nothing else to do work on it instead
+        bool rehashing = kvStore_->rehashing();
+        if (!loop_->poll(events, !rehashing)) {
+            break;
+        }
+        if (events.empty()) {
+            kvStore_->rehashFor(IDLE_REHASH_BUDGET);
+            continue;
+        }
+
+        bool woken = false;
+        for (const EventLoop::Event& event : events) {
+            if (event.kind == EventLoop::Event::Kind::Accept) {
+                addClient(event.fd);
+                continue;
+            }
+            if (event.kind == EventLoop::Event::Kind::Wake) {
+                woken = true;
+                continue;
+            }
+            auto it = clients_.find(event.fd);
+            if (it == clients_.end()) {
+                continue;
+            }
+            if (event.kind == EventLoop::Event::Kind::Input) {
+                it->second.readReady = true;
+            }
+            schedule(it->second);
+        }
+
+        // Replies from other shards answer older requests than anything
+        // read this iteration, so they go first
+        if (woken) {
+            handleMailbox();
+        }
+        processBatch();
+
+        // One mailbox push per peer for everything this iteration produced
+        flushOutboxes();
+    }
+}
+
+void Reactor::stop() {
+    stopping_.store(true, std::memory_order_release);
+    if (wakeFd_ != -1) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+size_t Reactor::shardOf(std::string_view key, size_t shards) {
+    // A hash tag, as in Redis Cluster: only a non-empty {...} is hashed
+    size_t open = key.find('{');
+    if (open != std::string_view::npos) {
+        size_t close = key.find('}', open + 1);
+        if (close != std::string_view::npos && close > open + 1) {
+            key = key.substr(open + 1, close - open - 1);
+        }
+    }
+    // Mix the hash so the shard doesn't correlate with the store's buckets
+    uint64_t h = std::hash<std::string_view> {}(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h % shards;
+}
+
+bool Reactor::setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1) {
+        std::cerr << "Failed to get socket flags: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        std::cerr << "Failed to set non-blocking: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void Reactor::addClient(int fd) {
+    std::cout << "New connection: fd=" << fd << std::endl;
+
+    Connection& conn = clients_[fd];
+    conn.id = nextConnId_++;
+    conn.fd = fd;
+    if (!loop_->watch(conn)) {
+        clients_.erase(fd);
+        close(fd);
+    }
+}
+
+void Reactor::schedule(Connection& conn) {
+    if (!conn.scheduled) {
+        conn.scheduled = true;
+        batch_.push_back(&conn);
+    }
+}
+
+void Reactor::processBatch() {
+    ioThreads_->parallelFor(batch_.size(), [this](size_t i) {
+        readInput(*batch_[i]);
+    });
+    for (Connection* conn : batch_) {
+        executeRequests(*conn);
+    }
+    ioThreads_->parallelFor(batch_.size(), [this](size_t i) {
+        writeOutput(*batch_[i]);
+    });
+    for (Connection* conn : batch_) {
+        finishBatch(*conn);
+    }
+    batch_.clear();
+}
+
+// Runs on an I/O thread: must only touch this connection
+void Reactor::readInput(Connection& conn) {
+    if (!conn.readReady || conn.closeAfterWrite) {
+        return;
+    }
+    conn.readReady = false;
+
+    if (!loop_->receive(conn)) {
+        conn.readClosed = true;
+        return;
+    }
+
+    try {
+        size_t first = conn.args.size();
+        while (conn.decoder.nextCommand(conn.args)) {
+            conn.requests.push_back(conn.args.size() - first);
+            first = conn.args.size();
+        }
+    } catch (const std::exception& e) {
+        conn.protocolError = e.what();
+    }
+}
+
+void Reactor::executeRequests(Connection& conn) {
+    if (conn.readClosed) {
+        return;
+    }
+
+    size_t first = 0;
+    for (size_t count : conn.requests) {
+        command::CommandArgs args(conn.args.data() + first, count);
+        first += count;
+        const command::CommandSpec* spec = command::findCommand(args[0]);
+        if (spec && spec->has(command::CommandSpec::Transaction) && spec->acceptsArgCount(args.size())) {
+            runTransactionCommand(conn, *spec, args);
+            continue;
+        }
+        if (conn.transaction.active()) {
+            queueRequest(conn, args);
+            continue;
+        }
+        std::optional<size_t> shard = route(args);
+        if (!shard) {
+            reply(conn, crossSlotError());
+        } else if (*shard != index_) {
+            forward(*shard, conn, conn.fd, args);
+        } else {
+            reply(conn, processor_->execute(args));
+        }
+    }
+    conn.requests.clear();
+    conn.args.clear();
+
+    if (!conn.protocolError.empty()) {
+        reply(conn, codec::err("ERR Protocol error: " + conn.protocolError));
+        conn.protocolError.clear();
+        conn.closeAfterWrite = true;
+    }
+}
+
+void Reactor::reply(Connection& conn, codec::CodecValue value) {
+    if (conn.awaiting.empty()) {
+        conn.replies.push_back(std::move(value));
+    } else {
+        conn.awaiting.emplace_back(codec::Codec::encode(value));
+    }
+}
+
+// Runs on an I/O thread: must only touch this connection
+void Reactor::writeOutput(Connection& conn) {
+    if (conn.readClosed) {
+        return;
+    }
+    encodeReplies(conn);
+    if (!loop_->transmit(conn)) {
+        conn.writeFailed = true;
+    }
+}
+
+void Reactor::finishBatch(Connection& conn) {
+    conn.scheduled = false;
+    int fd = conn.fd;
+
+    if (conn.readClosed) {
+        std::cout << "Client disconnected: fd=" << fd << std::endl;
+        closeClient(fd);
+        return;
+    }
+    if (conn.writeFailed) {
+        std::cerr << "Write error: fd=" << fd << std::endl;
+        closeClient(fd);
+        return;
+    }
+    if (conn.closeAfterWrite && conn.awaiting.empty() && !loop_->hasPendingOutput(conn)) {
+        closeClient(fd);
+        return;
+    }
+    if (!loop_->settle(conn)) {
+        closeClient(fd);
+    }
+}
+
+void Reactor::closeClient(int fd) {
+    auto it = clients_.find(fd);
+    if (it != clients_.end()) {
+        unwatch(it->second);
+        loop_->unwatch(it->second);
+    }
+    close(fd);
+    clients_.erase(fd);
+}
+
+// Sets shard to the one owning every key the request names, going by the
+// command table. Leaves it empty for requests without keys, ones the
+// processor will reject, and with a single shard. Returns false if the keys
+// are spread over several shards.
+bool Reactor::keysShard(command::CommandArgs args, std::optional<size_t>& shard) const {
+    if (peers_.size() <= 1 || args.empty()) {
+        return true;
+    }
+    const command::CommandSpec* spec = command::findCommand(args[0]);
+    if (!spec || !spec->acceptsArgCount(args.size())) {
+        return true;
+    }
+
+    bool spread = false;
+    command::forEachKey(*spec, args, [&](std::string_view key) {
+        size_t owner = shardOf(key, peers_.size());
+        spread |= shard && *shard != owner;
+        shard = owner;
+    });
+    return !spread;
+}
+
+// The shard to run the request on: the one owning its keys, or this one.
+// std::nullopt if the keys are spread over several shards.
+std::optional<size_t> Reactor::route(command::CommandArgs args) const {
+    std::optional<size_t> shard;
+    if (!keysShard(args, shard)) {
+        return std::nullopt;
+    }
+    return shard.value_or(index_);
+}
+
+void Reactor::forward(size_t shard, Connection& conn, int fd, command::CommandArgs args, command::WatcherId watcher,
+                      std::span<const size_t> requests) {
+    auto* envelope = new Envelope;
+    envelope->origin = index_;
+    envelope->fd = fd;
+    envelope->connId = conn.id;
+    envelope->seq = conn.awaitingBase + conn.awaiting.size();
+    envelope->request.assign(args.begin(), args.end());
+    envelope->watcher = watcher;
+    envelope->requests.assign(requests.begin(), requests.end());
+    conn.awaiting.emplace_back(std::nullopt);
+    deliver(shard, envelope);
+}
+
+// Runs a request sent here because this shard owns its keys
+codec::CodecValue Reactor::runForwarded(const Envelope& envelope) {
+    std::vector<std::string_view> args(envelope.request.begin(), envelope.request.end());
+    if (envelope.watcher == 0) {
+        return processor_->execute(args);
+    }
+    command::CommandArgs rest = command::CommandArgs(args).subspan(1);
+    std::string_view name = command::findCommand(args[0])->name;
+    if (name == "WATCH") {
+        processor_->watch(envelope.watcher, rest);
+        return codec::ok();
+    }
+    if (name == "UNWATCH") {
+        processor_->unwatch(envelope.watcher);
+        return codec::ok();
+    }
+    return processor_->exec(envelope.watcher, rest, envelope.requests);
+}
+
+void Reactor::deliver(size_t target, Envelope* envelope) {
+    Outbox& outbox = outboxes_[target];
+    envelope->next = outbox.newest;
+    outbox.newest = envelope;
+    if (!outbox.oldest) {
+        outbox.oldest = envelope;
+    }
+}
+
+void Reactor::flushOutboxes() {
+    for (size_t shard = 0; shard < outboxes_.size(); ++shard) {
+        Outbox& outbox = outboxes_[shard];
+        if (!outbox.newest) {
+            continue;
+        }
+        Reactor* peer = peers_[shard];
+        if (peer->mailbox_.push(outbox.newest, outbox.oldest)) {
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = write(peer->wakeFd_, &one, sizeof(one));
+        }
+        outbox = Outbox {};
+    }
+}
+
+void Reactor::handleMailbox() {
+    uint64_t count;
+    while (read(wakeFd_, &count, sizeof(count)) > 0) {
+    }
+
+    for (Envelope* envelope = mailbox_.drain(); envelope;) {
+        Envelope* next = envelope->next;
+
+        if (envelope->kind == Envelope::Kind::Request) {
+            envelope->reply = codec::Codec::encode(runForwarded(*envelope));
+            envelope->request.clear();
+            envelope->kind = Envelope::Kind::Reply;
+            deliver(envelope->origin, envelope);
+        } else {
+            // The client may have gone away, and its fd been reused, meanwhile
+            auto it = clients_.find(envelope->fd);
+            if (it != clients_.end() && it->second.id == envelope->connId) {
+                fillSlot(it->second, envelope->seq, std::move(envelope->reply));
+                schedule(it->second);
+            }
+            delete envelope;
+        }
+
+        envelope = next;
+    }
+}
+
+void Reactor::fillSlot(Connection& conn, uint64_t seq, std::string reply) {
+    // Replies still waiting to be encoded answer older requests
+    encodeReplies(conn);
+    conn.awaiting[seq - conn.awaitingBase] = std::move(reply);
+    while (!conn.awaiting.empty() && conn.awaiting.front()) {
+        conn.output += *conn.awaiting.front();
+        conn.awaiting.pop_front();
+        ++conn.awaitingBase;
+    }
+}
+
+void Reactor::encodeReplies(Connection& conn) {
+    for (const codec::CodecValue& reply : conn.replies) {
+        codec::Codec::encodeInto(reply, conn.output);
+    }
+    conn.replies.clear();
+}
+
+// MULTI, EXEC, DISCARD, WATCH and UNWATCH, which act on the connection
+void Reactor::runTransactionCommand(Connection& conn, const command::CommandSpec& spec, command::CommandArgs args) {
+    command::Transaction& transaction = conn.transaction;
+
+    if (spec.name == "MULTI") {
+        if (transaction.active()) {
+            reply(conn, codec::err("ERR MULTI calls can not be nested"));
+            return;
+        }
+        transaction.begin();
+        reply(conn, codec::ok());
+    } else if (spec.name == "WATCH") {
+        if (transaction.active()) {
+            reply(conn, codec::err("ERR WATCH inside MULTI is not allowed"));
+            return;
+        }
+        if (!pinTransaction(conn, args)) {
+            reply(conn, crossSlotError());
+            return;
+        }
+        conn.watching = true;
+        size_t shard = conn.transactionShard.value_or(index_);
+        if (shard != index_) {
+            forward(shard, conn, conn.fd, args, watcherOf(conn));
+            return;
+        }
+        processor_->watch(watcherOf(conn), args.subspan(1));
+        reply(conn, codec::ok());
+    } else if (spec.name == "UNWATCH") {
+        // Queued like any other command inside a block, as in Redis
+        if (transaction.active()) {
+            queueRequest(conn, args);
+            return;
+        }
+        endTransaction(conn);
+        reply(conn, codec::ok());
+    } else if (spec.name == "DISCARD") {
+        if (!transaction.active()) {
+            reply(conn, codec::err("ERR DISCARD without MULTI"));
+            return;
+        }
+        endTransaction(conn);
+        reply(conn, codec::ok());
+    } else {
+        if (!transaction.active()) {
+            reply(conn, codec::err("ERR EXEC without MULTI"));
+            return;
+        }
+        if (transaction.failed()) {
+            endTransaction(conn);
+            reply(conn, codec::err("EXECABORT Transaction discarded because of previous errors."));
+            return;
+        }
+        // exec releases the watches on the shard it runs on
+        conn.watching = false;
+        size_t shard = conn.transactionShard.value_or(index_);
+        std::vector<std::string_view> queued = transaction.args();
+        if (shard == index_) {
+            reply(conn, processor_->exec(watcherOf(conn), queued, transaction.requests()));
+        } else {
+            queued.insert(queued.begin(), spec.name);
+            forward(shard, conn, conn.fd, queued, watcherOf(conn), transaction.requests());
+        }
+        endTransaction(conn);
+    }
+}
+
+void Reactor::queueRequest(Connection& conn, command::CommandArgs args) {
+    if (!pinTransaction(conn, args)) {
+        conn.transaction.fail();
+        reply(conn, crossSlotError());
+        return;
+    }
+    reply(conn, conn.transaction.queue(args));
+}
+
+// Checks the request's keys are on the shard the connection's transaction
+// is pinned to, pinning it to theirs if it isn't pinned yet
+bool Reactor::pinTransaction(Connection& conn, command::CommandArgs args) {
+    std::optional<size_t> shard;
+    if (!keysShard(args, shard)) {
+        return false;
+    }
+    if (shard && conn.transactionShard && *conn.transactionShard != *shard) {
+        return false;
+    }
+    if (shard) {
+        conn.transactionShard = shard;
+    }
+    return true;
+}
+
+void Reactor::unwatch(Connection& conn) {
+    if (!conn.watching) {
+        return;
+    }
+    conn.watching = false;
+    size_t shard = conn.transactionShard.value_or(index_);
+    if (shard == index_) {
+        processor_->unwatch(watcherOf(conn));
+        return;
+    }
+    // No reply slot: connection id 0 matches no client, so the reply is
+    // dropped when it comes back
+    auto* envelope = new Envelope;
+    envelope->origin = index_;
+    envelope->request = {"UNWATCH"};
+    envelope->watcher = watcherOf(conn);
+    deliver(shard, envelope);
+}
+
+void Reactor::endTransaction(Connection& conn) {
+    unwatch(conn);
+    conn.transaction.clear();
+    conn.transactionShard.reset();
+}
+
+// Connection ids are only unique per reactor
+command::WatcherId Reactor::watcherOf(const Connection& conn) const {
+    return static_cast<command::WatcherId>(index_) << 48 | conn.id;
+}
+
+} // namespace server
@@ -0,0 +1,159 @@
+#pragma once
+#include "CommandProcessor.h"
+#include "CommandTable.h"
+#include "EventLoop.h"
+#include "IoThreadPool.h"
+#include "KeyValueStore.h"
+#include "Mailbox.h"
+#include "StreamDecoder.h"
+#include "Transaction.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace server {
+
+struct Connection {
+    uint64_t id = 0;
+    int fd = -1;
+    codec::StreamDecoder decoder;
+    // Decoded requests waiting to run: their arguments back to back, viewing
+    // the decoder's buffer, and how many arguments each request has
+    std::vector<std::string_view> args;
+    std::vector<size_t> requests;
+    std::string protocolError; // Set when decoding failed
+    std::vector<codec::CodecValue> replies; // Waiting to be encoded
+    std::string output; // Encoded replies, written from outputSent onwards
+    size_t outputSent = 0;
+    bool scheduled = false; // Already in this iteration's batch
+    bool readReady = false;
+    bool readClosed = false; // EOF or read error
+    bool writeFailed = false;
+    bool wantWrite = false; // Registered for write readiness
+    bool closeAfterWrite = false; // Close once output drains
+    // Reply slots for requests forwarded to other shards, oldest first.
+    // Replies queue behind an unfilled slot to keep pipeline order.
+    std::deque<std::optional<std::string>> awaiting;
+    uint64_t awaitingBase = 0; // Sequence number of awaiting.front()
+    // A MULTI block and the keys it watches must all be on one shard, where
+    // EXEC runs the block back to back. The first key watched or queued
+    // picks the shard.
+    command::Transaction transaction;
+    std::optional<size_t> transactionShard;
+    bool watching = false; // Has keys watched on transactionShard
+};
+
+// A request forwarded to the shard that owns its key, sent back to the
+// client's reactor carrying the encoded reply.
+struct Envelope {
+    enum class Kind {
+        Request,
+        Reply
+    };
+
+    Kind kind = Kind::Request;
+    size_t origin = 0; // Reactor that owns the connection
+    int fd = -1;
+    uint64_t connId = 0;
+    uint64_t seq = 0; // Reply slot on the connection
+    std::vector<std::string> request; // Owned, the client's buffer moves on
+    std::string reply;
+    // WATCH, UNWATCH and EXEC act for the client, and EXEC carries a whole
+    // MULTI block: request holds EXEC then each queued request's arguments,
+    // and requests how many each has
+    command::WatcherId watcher = 0;
+    std::vector<size_t> requests;
+    Envelope* next = nullptr;
+};
+
+// One event loop thread: its own listen socket, EventLoop and shard of the
+// keyspace. Reactors only talk to each other through their mailboxes.
+//
+// Each loop iteration handles the ready connections as a batch: reading and
+// decoding, then running commands, then encoding and writing. The first and
+// last phases touch only their own connection and are spread over the I/O
+// thread pool; commands always run on the reactor thread, so the store
+// needs no locking.
+class Reactor {
+public:
+    Reactor(size_t index, int port, size_t ioThreads = 0, EventLoop::Backend backend = EventLoop::Backend::Epoll);
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    // reusePort lets several reactors bind the same port; the kernel then
+    // spreads incoming connections across their listen sockets. Falls back
+    // to epoll if the requested backend can't be set up.
+    bool start(bool reusePort);
+    EventLoop::Backend backend() const { return backend_; }
+    void setPeers(std::vector<Reactor*> peers);
+    void run();
+    // Safe to call from any thread or a signal handler
+    void stop();
+
+    // Keys sharing a {hash tag} share a shard
+    static size_t shardOf(std::string_view key, size_t shards);
+
+private:
+    bool setNonBlocking(int fd);
+    void addClient(int fd);
+    void schedule(Connection& conn);
+    void processBatch();
+    void readInput(Connection& conn);
+    void executeRequests(Connection& conn);
+    void reply(Connection& conn, codec::CodecValue value);
+    void writeOutput(Connection& conn);
+    void finishBatch(Connection& conn);
+    void closeClient(int fd);
+
+    bool keysShard(command::CommandArgs args, std::optional<size_t>& shard) const;
+    std::optional<size_t> route(command::CommandArgs args) const;
+    void forward(size_t shard, Connection& conn, int fd, command::CommandArgs args, command::WatcherId watcher = 0,
+                 std::span<const size_t> requests = {});
+    codec::CodecValue runForwarded(const Envelope& envelope);
+    void deliver(size_t target, Envelope* envelope);
+    void handleMailbox();
+    void flushOutboxes();
+    void fillSlot(Connection& conn, uint64_t seq, std::string reply);
+    void encodeReplies(Connection& conn);
+
+    void runTransactionCommand(Connection& conn, const command::CommandSpec& spec, command::CommandArgs args);
+    void queueRequest(Connection& conn, command::CommandArgs args);
+    bool pinTransaction(Connection& conn, command::CommandArgs args);
+    void unwatch(Connection& conn);
+    void endTransaction(Connection& conn);
+    command::WatcherId watcherOf(const Connection& conn) const;
+
+    size_t index_;
+    int port_;
+    EventLoop::Backend backend_;
+    std::unique_ptr<EventLoop> loop_;
+    int socketFd_;
+    int wakeFd_;
+    std::atomic<bool> stopping_ { false };
+    uint64_t nextConnId_ = 1;
+    std::unique_ptr<storage::KeyValueStore> kvStore_;
+    std::unique_ptr<command::CommandProcessor> processor_;
+    std::unordered_map<int, Connection> clients_;
+    std::vector<Connection*> batch_;
+    std::unique_ptr<IoThreadPool> ioThreads_;
+
+    std::vector<Reactor*> peers_; // Every reactor, indexed by shard
+    Mailbox<Envelope> mailbox_;
+    // Envelopes collected this iteration, per destination, newest first
+    struct Outbox {
+        Envelope* newest = nullptr;
+        Envelope* oldest = nullptr;
+    };
+    std::vector<Outbox> outboxes_;
+};
+
+} // namespace server
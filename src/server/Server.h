@@ -1,35 +1,33 @@
 #pragma once
-#include "CommandProcessor.h"
-#include "KeyValueStore.h"
+#include "Reactor.h"
+#include <atomic>
 #include <memory>
-#include <string>
-#include <unordered_map>
+#include <thread>
+#include <vector>
 
 namespace server {
 
 class Server {
 public:
-    explicit Server(int port);
+    // With more than one reactor, each runs its own event loop thread with
+    // its own SO_REUSEPORT listen socket and shard of the keyspace. ioThreads
+    // helper threads per reactor take over socket reads/writes and RESP
+    // decoding/encoding, leaving only command execution on the reactor.
+    explicit Server(int port, size_t reactors = 1, size_t ioThreads = 0,
+        EventLoop::Backend backend = EventLoop::Backend::Epoll);
     ~Server();
 
     bool start();
+    // Runs the first reactor on the calling thread and the rest on their own
+    // threads. Returns once stop() has been called.
     void run();
     void stop();
 
 private:
-    bool setNonBlocking(int fd);
-    void handleAccept();
-    void handleClient(int fd);
-    void processMessages(int fd);
-    void sendResponse(int fd, const std::string& data);
-    void closeClient(int fd);
-
     int port_;
-    int epollFd_;
-    int socketFd_;
-    std::unique_ptr<storage::KeyValueStore> kvStore_;
-    std::unique_ptr<command::CommandProcessor> processor_;
-    std::unordered_map<int, std::string> clientBuffers_;
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_{false};
 };
 
 } // namespace server
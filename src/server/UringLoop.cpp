@@ -0,0 +1,485 @@
+#include "UringLoop.h"
+#include "Reactor.h"
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace server {
+
+constexpr unsigned QUEUE_DEPTH = 1024;
+constexpr unsigned BUFFER_COUNT = 1024;
+constexpr unsigned BUFFER_SIZE = 4096;
+constexpr uint16_t BUFFER_GROUP = 0;
+constexpr int ID_BITS = 56;
+// Times a full SQ is submitted to make room before giving up on the request
+constexpr int MAX_SUBMIT_ATTEMPTS = 4;
+
+UringLoop::~UringLoop() {
+    // Closing the ring cancels everything still in flight
+    if (ringFd_ != -1) {
+        close(ringFd_);
+    }
+    if (sqes_) {
+        munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_ && cqRing_ != sqRing_) {
+        munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_) {
+        munmap(sqRing_, sqRingSize_);
+    }
+    std::free(buffers_);
+}
+
+bool UringLoop::start(int listenFd, int wakeFd) {
+    listenFd_ = listenFd;
+    wakeFd_ = wakeFd;
+
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = QUEUE_DEPTH * 4;
+    ringFd_ = static_cast<int>(syscall(__NR_io_uring_setup, QUEUE_DEPTH, &params));
+    if (ringFd_ == -1) {
+        std::cerr << "Failed to set up io_uring: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (!supported()) {
+        std::cerr << "io_uring lacks multishot accept and recv (Linux 6.0)" << std::endl;
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        std::cerr << "Failed to map io_uring SQ: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            cqRing_ = nullptr;
+            std::cerr << "Failed to map io_uring CQ: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        std::cerr << "Failed to map io_uring SQEs: " << strerror(errno) << std::endl;
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    sqeTail_ = *sqTail_;
+
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Pool of provided buffers that recv picks from. Buffers go back to the
+    // kernel with PROVIDE_BUFFERS rather than through a registered buffer
+    // ring, which isn't usable on every kernel that accepts its registration.
+    buffers_ = static_cast<char*>(std::aligned_alloc(4096, BUFFER_COUNT * BUFFER_SIZE));
+    if (!buffers_) {
+        std::cerr << "Failed to allocate io_uring buffers" << std::endl;
+        return false;
+    }
+    for (unsigned i = 0; i < BUFFER_COUNT; ++i) {
+        recycle(static_cast<uint16_t>(i));
+    }
+    publishBuffers();
+
+    armAccept();
+    armWake();
+    return true;
+}
+
+uint64_t UringLoop::tag(Op op, uint64_t id) {
+    return (static_cast<uint64_t>(op) << ID_BITS) | id;
+}
+
+// Whether the kernel has every operation this loop relies on. Multishot
+// accept and recv are request flags a probe can't see, and io_uring_setup
+// succeeds on kernels without them, where every accept would fail with
+// EINVAL. SEND_ZC arrived in 6.0 alongside multishot recv, a release after
+// multishot accept, so it stands in for both.
+bool UringLoop::supported() const {
+    std::vector<char> storage(sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op));
+    auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+    if (syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0) {
+        return false;
+    }
+    for (unsigned op : {IORING_OP_ACCEPT, IORING_OP_READ, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_PROVIDE_BUFFERS,
+                        IORING_OP_ASYNC_CANCEL, IORING_OP_SEND_ZC}) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+io_uring_sqe* UringLoop::nextSqe() {
+    // The SQ is full: hand what's queued to the kernel to make room. The
+    // kernel may refuse more while completions go unreaped, so only so many
+    // tries.
+    for (int attempt = 0; sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_; ++attempt) {
+        if (attempt == MAX_SUBMIT_ATTEMPTS) {
+            std::cerr << "io_uring submission queue full" << std::endl;
+            return nullptr;
+        }
+        if (enter(toSubmit_, 0, 0) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            std::cerr << "io_uring_enter failed: " << strerror(errno) << std::endl;
+            return nullptr;
+        }
+    }
+
+    unsigned index = sqeTail_ & sqMask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray_[index] = index;
+    ++sqeTail_;
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    ++toSubmit_;
+    return sqe;
+}
+
+int UringLoop::enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags, nullptr, 0));
+    if (ret > 0) {
+        toSubmit_ -= std::min<unsigned>(ret, toSubmit_);
+    }
+    return ret;
+}
+
+void UringLoop::armAccept() {
+    if (io_uring_sqe* sqe = nextSqe()) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listenFd_;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->user_data = tag(Op::Accept, 0);
+    }
+}
+
+void UringLoop::armWake() {
+    if (io_uring_sqe* sqe = nextSqe()) {
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = wakeFd_;
+        sqe->addr = reinterpret_cast<uint64_t>(&wakeValue_);
+        sqe->len = sizeof(wakeValue_);
+        sqe->user_data = tag(Op::Wake, 0);
+    }
+}
+
+void UringLoop::armRecv(uint64_t id, Socket& socket) {
+    if (io_uring_sqe* sqe = nextSqe()) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = socket.fd;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->user_data = tag(Op::Recv, id);
+        socket.recvArmed = true;
+        ++socket.inflight;
+    }
+}
+
+void UringLoop::armSend(uint64_t id, Socket& socket) {
+    if (io_uring_sqe* sqe = nextSqe()) {
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = socket.fd;
+        sqe->addr = reinterpret_cast<uint64_t>(socket.sending.data() + socket.sendOffset);
+        sqe->len = static_cast<uint32_t>(socket.sending.size() - socket.sendOffset);
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = tag(Op::Send, id);
+        if (!socket.sendInFlight) {
+            socket.sendInFlight = true;
+            ++socket.inflight;
+        }
+    } else {
+        socket.writeFailed = true;
+    }
+}
+
+void UringLoop::recycle(uint16_t bufferId) {
+    returned_.push_back(bufferId);
+}
+
+// One PROVIDE_BUFFERS per run of consecutive ids, submitted with the next wait
+void UringLoop::publishBuffers() {
+    if (returned_.empty()) {
+        return;
+    }
+    std::sort(returned_.begin(), returned_.end());
+
+    size_t first = 0;
+    while (first < returned_.size()) {
+        size_t last = first + 1;
+        while (last < returned_.size() && returned_[last] == returned_[last - 1] + 1) {
+            ++last;
+        }
+        if (io_uring_sqe* sqe = nextSqe()) {
+            sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+            sqe->fd = static_cast<int>(last - first);
+            sqe->addr = reinterpret_cast<uint64_t>(buffers_ + static_cast<size_t>(returned_[first]) * BUFFER_SIZE);
+            sqe->len = BUFFER_SIZE;
+            sqe->off = returned_[first];
+            sqe->buf_group = BUFFER_GROUP;
+            sqe->user_data = tag(Op::Provide, 0);
+        }
+        first = last;
+    }
+    returned_.clear();
+
+    // Sockets that ran dry can receive again
+    for (uint64_t id : starved_) {
+        auto it = sockets_.find(id);
+        if (it != sockets_.end() && !it->second.closed && !it->second.recvArmed && !it->second.hangup) {
+            it->second.starved = false;
+            armRecv(id, it->second);
+        }
+    }
+    starved_.clear();
+}
+
+bool UringLoop::poll(std::vector<Event>& events, bool wait) {
+    publishBuffers();
+
+    do {
+        // Submits everything queued since the last call and, if asked to,
+        // waits, in one syscall
+        unsigned minComplete = wait ? 1 : 0;
+        unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+        if (enter(toSubmit_, minComplete, flags) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            std::cerr << "io_uring_enter failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        unsigned head = *cqHead_;
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            complete(cqes_[head & cqMask_], events);
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        publishBuffers();
+    } while (wait && events.empty());
+
+    return true;
+}
+
+void UringLoop::complete(const io_uring_cqe& cqe, std::vector<Event>& events) {
+    Op op = static_cast<Op>(cqe.user_data >> ID_BITS);
+    uint64_t id = cqe.user_data & ((1ULL << ID_BITS) - 1);
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+
+    switch (op) {
+    case Op::Accept:
+        if (cqe.res >= 0) {
+            events.push_back({Event::Kind::Accept, cqe.res});
+        } else if (cqe.res != -ECANCELED) {
+            std::cerr << "Accept failed: " << strerror(-cqe.res) << std::endl;
+        }
+        // Errors a later accept can get past re-arm; anything else would
+        // fail the same way at once, so accepting stops
+        if (!more && (cqe.res >= 0 || cqe.res == -ECONNABORTED || cqe.res == -EINTR || cqe.res == -EAGAIN
+                      || cqe.res == -EMFILE || cqe.res == -ENFILE || cqe.res == -ENOBUFS || cqe.res == -ENOMEM)) {
+            armAccept();
+        } else if (!more && cqe.res != -ECANCELED) {
+            std::cerr << "No longer accepting connections" << std::endl;
+        }
+        return;
+
+    case Op::Wake:
+        events.push_back({Event::Kind::Wake, wakeFd_});
+        armWake();
+        return;
+
+    case Op::Cancel:
+        return;
+
+    case Op::Provide:
+        if (cqe.res < 0) {
+            std::cerr << "Failed to provide io_uring buffers: " << strerror(-cqe.res) << std::endl;
+        }
+        return;
+
+    case Op::Recv:
+    case Op::Send:
+        break;
+    }
+
+    auto it = sockets_.find(id);
+    if (it == sockets_.end()) {
+        return;
+    }
+    Socket& socket = it->second;
+
+    if (op == Op::Recv) {
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            auto bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res > 0 && !socket.closed) {
+                socket.input.push_back({bufferId, static_cast<uint32_t>(cqe.res)});
+            } else {
+                recycle(bufferId);
+            }
+        }
+        // Out of buffers just ends the multishot; it's re-armed once some
+        // have been handed back
+        if (cqe.res == -ENOBUFS && !socket.closed) {
+            socket.starved = true;
+            starved_.push_back(id);
+        } else if (cqe.res <= 0) {
+            socket.hangup = true;
+        }
+        if (!more) {
+            socket.recvArmed = false;
+            --socket.inflight;
+        }
+        if (!socket.closed && cqe.res != -ENOBUFS) {
+            events.push_back({Event::Kind::Input, socket.fd});
+        }
+    } else {
+        if (cqe.res < 0) {
+            socket.writeFailed = true;
+        } else {
+            socket.sendOffset += cqe.res;
+        }
+        if (!socket.writeFailed && !socket.closed && socket.sendOffset < socket.sending.size()) {
+            armSend(id, socket); // Short send: queue the rest
+            return;
+        }
+        socket.sendInFlight = false;
+        --socket.inflight;
+        socket.sending.clear();
+        socket.sendOffset = 0;
+        if (!socket.closed) {
+            events.push_back({Event::Kind::Output, socket.fd});
+        }
+    }
+
+    if (socket.closed && socket.inflight == 0) {
+        release(id);
+    }
+}
+
+bool UringLoop::watch(Connection& conn) {
+    Socket& socket = sockets_[conn.id];
+    socket.fd = conn.fd;
+    armRecv(conn.id, socket);
+    return socket.recvArmed;
+}
+
+void UringLoop::unwatch(Connection& conn) {
+    auto it = sockets_.find(conn.id);
+    if (it == sockets_.end()) {
+        return;
+    }
+    Socket& socket = it->second;
+    socket.closed = true;
+
+    for (const Chunk& chunk : socket.input) {
+        recycle(chunk.bufferId);
+    }
+    socket.input.clear();
+
+    if (socket.recvArmed) {
+        if (io_uring_sqe* sqe = nextSqe()) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = tag(Op::Recv, conn.id);
+            sqe->user_data = tag(Op::Cancel, conn.id);
+        }
+    }
+    // Makes any send still in flight finish instead of waiting on the peer
+    shutdown(socket.fd, SHUT_RDWR);
+
+    if (socket.inflight == 0) {
+        release(conn.id);
+    }
+}
+
+void UringLoop::release(uint64_t id) {
+    sockets_.erase(id);
+}
+
+// Runs on an I/O thread; only reads sockets_, which the reactor thread
+// doesn't modify while a batch is in its parallel phases
+bool UringLoop::receive(Connection& conn) {
+    auto it = sockets_.find(conn.id);
+    if (it == sockets_.end()) {
+        return false;
+    }
+    Socket& socket = it->second;
+
+    for (; socket.consumed < socket.input.size(); ++socket.consumed) {
+        const Chunk& chunk = socket.input[socket.consumed];
+        conn.decoder.feed(buffers_ + static_cast<size_t>(chunk.bufferId) * BUFFER_SIZE, chunk.len);
+    }
+    return !socket.hangup;
+}
+
+// Sends are submitted from settle() on the reactor thread
+bool UringLoop::transmit(Connection& conn) {
+    auto it = sockets_.find(conn.id);
+    return it != sockets_.end() && !it->second.writeFailed;
+}
+
+bool UringLoop::settle(Connection& conn) {
+    auto it = sockets_.find(conn.id);
+    if (it == sockets_.end()) {
+        return false;
+    }
+    Socket& socket = it->second;
+
+    // Hand the buffers the decoder has copied out back to the kernel
+    for (size_t i = 0; i < socket.consumed; ++i) {
+        recycle(socket.input[i].bufferId);
+    }
+    socket.input.erase(socket.input.begin(), socket.input.begin() + socket.consumed);
+    socket.consumed = 0;
+
+    if (!socket.recvArmed && !socket.hangup && !socket.starved) {
+        armRecv(conn.id, socket);
+    }
+
+    // New replies pile up in conn.output while a send is in flight; they go
+    // out as one send once it completes
+    if (!socket.sendInFlight && conn.outputSent < conn.output.size()) {
+        socket.sending.swap(conn.output);
+        socket.sendOffset = conn.outputSent;
+        conn.output.clear();
+        conn.outputSent = 0;
+        armSend(conn.id, socket);
+    }
+
+    return !socket.writeFailed;
+}
+
+bool UringLoop::hasPendingOutput(const Connection& conn) const {
+    auto it = sockets_.find(conn.id);
+    return !conn.output.empty() || (it != sockets_.end() && it->second.sendInFlight);
+}
+
+} // namespace server
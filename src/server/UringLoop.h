@@ -0,0 +1,103 @@
+#pragma once
+#include "EventLoop.h"
+#include <linux/io_uring.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace server {
+
+// Completion-based loop on io_uring, driven through the raw syscalls. One
+// multishot accept and one multishot recv per client stay armed. recv draws
+// from a pool of kernel-provided buffers, and sends are queued during a batch
+// and submitted together with the next wait, so a busy iteration costs a
+// single io_uring_enter.
+class UringLoop : public EventLoop {
+public:
+    ~UringLoop() override;
+
+    bool start(int listenFd, int wakeFd) override;
+    bool poll(std::vector<Event>& events, bool wait) override;
+    bool watch(Connection& conn) override;
+    void unwatch(Connection& conn) override;
+    bool receive(Connection& conn) override;
+    bool transmit(Connection& conn) override;
+    bool settle(Connection& conn) override;
+    bool hasPendingOutput(const Connection& conn) const override;
+
+private:
+    enum class Op : uint8_t {
+        Accept = 1,
+        Wake,
+        Recv,
+        Send,
+        Cancel,
+        Provide
+    };
+
+    struct Chunk {
+        uint16_t bufferId;
+        uint32_t len;
+    };
+
+    struct Socket {
+        int fd = -1;
+        std::vector<Chunk> input; // Received, in order
+        size_t consumed = 0; // Chunks already fed to the decoder
+        bool recvArmed = false;
+        bool starved = false; // recv ran out of buffers
+        bool hangup = false;
+        bool writeFailed = false;
+        bool closed = false; // Unwatched; kept until its requests complete
+        int inflight = 0; // Requests the kernel still holds
+        std::string sending; // Must stay put while the send is in flight
+        size_t sendOffset = 0;
+        bool sendInFlight = false;
+    };
+
+    static uint64_t tag(Op op, uint64_t id);
+
+    bool supported() const;
+    io_uring_sqe* nextSqe();
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+    void armAccept();
+    void armWake();
+    void armRecv(uint64_t id, Socket& socket);
+    void armSend(uint64_t id, Socket& socket);
+    void recycle(uint16_t bufferId);
+    void publishBuffers();
+    void complete(const io_uring_cqe& cqe, std::vector<Event>& events);
+    void release(uint64_t id);
+
+    int ringFd_ = -1;
+    int listenFd_ = -1;
+    int wakeFd_ = -1;
+    uint64_t wakeValue_ = 0;
+
+    void* sqRing_ = nullptr;
+    size_t sqRingSize_ = 0;
+    void* cqRing_ = nullptr;
+    size_t cqRingSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqesSize_ = 0;
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned sqeTail_ = 0; // Local copy of the SQ tail
+    unsigned toSubmit_ = 0;
+
+    char* buffers_ = nullptr;
+    std::vector<uint16_t> returned_; // Buffers to hand back to the kernel
+    std::vector<uint64_t> starved_; // Sockets waiting on returned buffers
+
+    std::unordered_map<uint64_t, Socket> sockets_; // By connection id
+};
+
+} // namespace server
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "FlatHashMap.h"
+#include <chrono>
+#include <utility>
+
+namespace storage {
+
+// A hash map that never resizes in one go, after Redis's dict. When the
+// table fills up, a bigger one takes its place and the old one drains into it
+// a few slots at a time: every operation moves REHASH_STEP slots, and
+// rehashFor() moves more while the server is idle. Until the old table is
+// empty, lookups check both tables and new keys only go to the new one.
+//
+// As with FlatHashMap, any later call may move entries, so pointers from
+// find() and try_emplace() are only good until the next call. The const
+// find() moves nothing, so its pointers survive other const calls.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class Dict {
+public:
+    using Table = FlatHashMap<Key, Value, Hash, Equal>;
+
+    // Slots of the old table moved by each lookup, insert or erase
+    static constexpr size_t REHASH_STEP = 64;
+
+    template <typename K>
+    Value* find(const K& key)
+    {
+        rehashStep(REHASH_STEP);
+        if (auto it = table_.find(key); it != table_.end())
+            return &it->second;
+        if (rehashing()) {
+            if (auto it = old_.find(key); it != old_.end())
+                return &it->second;
+        }
+        return nullptr;
+    }
+    template <typename K>
+    const Value* find(const K& key) const
+    {
+        if (auto it = table_.find(key); it != table_.end())
+            return &it->second;
+        if (rehashing()) {
+            if (auto it = old_.find(key); it != old_.end())
+                return &it->second;
+        }
+        return nullptr;
+    }
+    template <typename K>
+    bool contains(const K& key) { return find(key) != nullptr; }
+
+    // Returns the key's value, default-constructing it from args if the key
+    // is new, and whether it was inserted
+    template <typename K, typename... Args>
+    std::pair<Value*, bool> try_emplace(K&& key, Args&&... args)
+    {
+        rehashStep(REHASH_STEP);
+        if (rehashing()) {
+            if (auto it = old_.find(key); it != old_.end())
+                return { &it->second, false };
+        }
+        if (table_.full() && !table_.contains(key)) {
+            // Sized for twice the old table's entries, the new one only fills
+            // mid-rehash if inserts outrun the draining; finish it off then
+            rehashStep(old_.capacity());
+            startRehash();
+        }
+        auto [it, inserted] = table_.try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+        return { &it->second, inserted };
+    }
+
+    template <typename K>
+    size_t erase(const K& key)
+    {
+        rehashStep(REHASH_STEP);
+        if (table_.erase(key))
+            return 1;
+        return rehashing() ? old_.erase(key) : 0;
+    }
+
+    size_t size() const { return table_.size() + old_.size(); }
+    bool rehashing() const { return old_.capacity() != 0; }
+
+    // Drains the old table for up to budget. Returns true if there's more.
+    bool rehashFor(std::chrono::microseconds budget)
+    {
+        auto deadline = std::chrono::steady_clock::now() + budget;
+        while (rehashing()) {
+            rehashStep(REHASH_STEP * 16);
+            if (std::chrono::steady_clock::now() >= deadline)
+                break;
+        }
+        return rehashing();
+    }
+
+private:
+    void startRehash()
+    {
+        old_.swap(table_);
+        // Sized by entries rather than capacity, so a table full of
+        // tombstones drains into one no bigger than it needs
+        table_.reserve(old_.size() * 2);
+        cursor_ = 0;
+    }
+
+    void rehashStep(size_t slots)
+    {
+        if (!rehashing())
+            return;
+        cursor_ = old_.moveSlotsTo(table_, cursor_, slots);
+        if (cursor_ == old_.capacity())
+            old_.clear();
+    }
+
+    Table table_; // Where new keys go
+    Table old_; // Being drained into table_; empty with no capacity otherwise
+    size_t cursor_ = 0; // Next slot of old_ to move
+};
+
+} // namespace storage
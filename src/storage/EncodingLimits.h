@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+namespace storage {
+
+// When small collections give up their packed ListPack encoding for the full
+// structure, as with Redis's *-max-listpack-* settings. A collection converts
+// once it has more than the entry limit, or on the first element longer than
+// the value limit, and doesn't convert back.
+struct EncodingLimits {
+    size_t hashMaxListpackEntries = 128;
+    size_t hashMaxListpackValue = 64;
+    size_t setMaxListpackEntries = 128;
+    size_t setMaxListpackValue = 64;
+    // A set of integers stays an IntSet up to this many members
+    size_t setMaxIntsetEntries = 512;
+    // A list converts to a QuickList once its ListPack would pass this size
+    size_t listMaxListpackBytes = 8192;
+};
+
+} // namespace storage
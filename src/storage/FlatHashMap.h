@@ -0,0 +1,383 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace storage {
+
+namespace flat {
+    // Every slot has a control byte: EMPTY, DELETED, or the low seven bits
+    // of its key's hash (H2). Only full slots have the top bit clear.
+    using Ctrl = int8_t;
+    constexpr Ctrl EMPTY = -128;
+    constexpr Ctrl DELETED = -2;
+    constexpr size_t GROUP_WIDTH = 16;
+
+    // Sixteen consecutive control bytes, compared all at once. Each match
+    // method returns a mask with bit i set if byte i matches.
+    class Group {
+    public:
+#if defined(__SSE2__)
+        explicit Group(const Ctrl* ctrl)
+            : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)))
+        {
+        }
+
+        uint32_t match(Ctrl h2) const
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+        }
+        uint32_t matchEmpty() const { return match(EMPTY); }
+        // EMPTY and DELETED are the only bytes with the top bit set
+        uint32_t matchEmptyOrDeleted() const { return static_cast<uint32_t>(_mm_movemask_epi8(ctrl_)); }
+
+    private:
+        __m128i ctrl_;
+#else
+        explicit Group(const Ctrl* ctrl) { std::memcpy(ctrl_, ctrl, GROUP_WIDTH); }
+
+        uint32_t match(Ctrl h2) const
+        {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; ++i)
+                mask |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+            return mask;
+        }
+        uint32_t matchEmpty() const { return match(EMPTY); }
+        uint32_t matchEmptyOrDeleted() const
+        {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; ++i)
+                mask |= static_cast<uint32_t>(ctrl_[i] < 0) << i;
+            return mask;
+        }
+
+    private:
+        Ctrl ctrl_[GROUP_WIDTH];
+#endif
+    };
+} // namespace flat
+
+// Open-addressing hash map in the style of Abseil's Swiss tables. Entries sit
+// in one flat array with no allocation of their own. A lookup hashes once,
+// then checks control bytes sixteen at a time against the hash's low bits, so
+// it touches only the slots whose H2 matches.
+//
+// Lookups accept any type Hash and Equal do, so a transparent hash allows
+// std::string_view lookups in a map keyed by std::string. Unlike
+// std::unordered_map, any insert may move entries, invalidating iterators and
+// references. Erase leaves a tombstone that a later insert or grow reclaims.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class FlatHashMap {
+public:
+    using value_type = std::pair<Key, Value>;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using Map = std::conditional_t<Const, const FlatHashMap, FlatHashMap>;
+        using Entry = std::conditional_t<Const, const value_type, value_type>;
+
+        Iterator() = default;
+        Iterator(Map* map, size_t index)
+            : map_(map)
+            , index_(index)
+        {
+            skipEmpty();
+        }
+        operator Iterator<true>() const { return { map_, index_ }; }
+
+        Entry& operator*() const { return map_->slots_[index_]; }
+        Entry* operator->() const { return &map_->slots_[index_]; }
+        Iterator& operator++()
+        {
+            ++index_;
+            skipEmpty();
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+
+    private:
+        friend class FlatHashMap;
+
+        void skipEmpty()
+        {
+            while (index_ < map_->capacity_ && map_->ctrl_[index_] < 0)
+                ++index_;
+        }
+
+        Map* map_ = nullptr;
+        size_t index_ = 0;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashMap() = default;
+    FlatHashMap(const FlatHashMap& other)
+    {
+        reserve(other.size_);
+        for (const auto& [key, value] : other)
+            try_emplace(key, value);
+    }
+    FlatHashMap(FlatHashMap&& other) noexcept { swap(other); }
+    FlatHashMap& operator=(FlatHashMap other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+    ~FlatHashMap() { release(); }
+
+    void swap(FlatHashMap& other) noexcept
+    {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(growthLeft_, other.growthLeft_);
+    }
+
+    iterator begin() { return { this, 0 }; }
+    iterator end() { return { this, capacity_ }; }
+    const_iterator begin() const { return { this, 0 }; }
+    const_iterator end() const { return { this, capacity_ }; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return capacity_; }
+    // Bytes held by the table itself, not counting what entries point to
+    size_t memoryUsage() const { return capacity_ ? capacity_ * sizeof(value_type) + capacity_ + flat::GROUP_WIDTH - 1 : 0; }
+
+    template <typename K>
+    iterator find(const K& key) { return { this, findIndex(key, hasher_(key)) }; }
+    template <typename K>
+    const_iterator find(const K& key) const { return { this, findIndex(key, hasher_(key)) }; }
+    template <typename K>
+    bool contains(const K& key) const { return findIndex(key, hasher_(key)) != capacity_; }
+
+    // Looks the key up and, if it's missing, constructs the entry in the slot
+    // the same probe found, so a hit or an insert costs one hash.
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+        size_t hash = hasher_(key);
+        auto [index, found] = findOrPrepareInsert(key, hash);
+        if (found)
+            return { { this, index }, false };
+        std::construct_at(&slots_[index], std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+        commitInsert(index, hash);
+        return { { this, index }, true };
+    }
+
+    template <typename K, typename V>
+    std::pair<iterator, bool> insert_or_assign(K&& key, V&& value)
+    {
+        auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+        if (!result.second)
+            result.first->second = std::forward<V>(value);
+        return result;
+    }
+
+    void erase(const_iterator it)
+    {
+        std::destroy_at(&slots_[it.index_]);
+        setCtrl(it.index_, flat::DELETED);
+        --size_;
+    }
+    void erase(iterator it) { erase(const_iterator(it)); }
+    template <typename K>
+    size_t erase(const K& key)
+    {
+        size_t index = findIndex(key, hasher_(key));
+        if (index == capacity_)
+            return 0;
+        erase(const_iterator { this, index });
+        return 1;
+    }
+
+    void clear()
+    {
+        release();
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = size_ = growthLeft_ = 0;
+    }
+
+    // Grows so count entries fit without another resize
+    void reserve(size_t count)
+    {
+        if (count > maxLoad(capacity_))
+            resize(capacityFor(count));
+    }
+
+    // True when inserting a new key would resize the table first
+    bool full() const { return growthLeft_ == 0; }
+
+    // Moves the entries in slots [from, from + count) into target, which
+    // must not hold any of their keys, and returns where to continue. Lets
+    // a caller spread a resize over many calls; see Dict.
+    size_t moveSlotsTo(FlatHashMap& target, size_t from, size_t count)
+    {
+        size_t end = std::min(from + count, capacity_);
+        for (size_t i = from; i < end; ++i) {
+            if (ctrl_[i] < 0)
+                continue;
+            size_t hash = hasher_(slots_[i].first);
+            if (target.growthLeft_ == 0)
+                target.resize(capacityFor(target.size_ + 1));
+            size_t index = target.findInsertSlot(hash);
+            std::construct_at(&target.slots_[index], std::move(slots_[i]));
+            target.commitInsert(index, hash);
+            erase(const_iterator { this, i });
+        }
+        return end;
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = flat::GROUP_WIDTH;
+
+    // Load factor 7/8: probes stay short and a group nearly always has an
+    // empty byte to stop at
+    static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+    static size_t capacityFor(size_t count)
+    {
+        size_t capacity = MIN_CAPACITY;
+        while (maxLoad(capacity) < count)
+            capacity *= 2;
+        return capacity;
+    }
+
+    static size_t h1(size_t hash) { return hash >> 7; }
+    static flat::Ctrl h2(size_t hash) { return static_cast<flat::Ctrl>(hash & 0x7f); }
+
+    // Probes group by group with triangular steps, which on a power-of-two
+    // table visits every group before repeating one.
+    struct Probe {
+        size_t mask;
+        size_t offset;
+        size_t step = 0;
+
+        size_t at(size_t bit) const { return (offset + bit) & mask; }
+        void next()
+        {
+            step += flat::GROUP_WIDTH;
+            offset = (offset + step) & mask;
+        }
+    };
+    Probe probe(size_t hash) const { return { capacity_ - 1, h1(hash) & (capacity_ - 1) }; }
+
+    template <typename K>
+    size_t findIndex(const K& key, size_t hash) const
+    {
+        if (capacity_ == 0)
+            return 0;
+        for (Probe seq = probe(hash);; seq.next()) {
+            flat::Group group(ctrl_ + seq.offset);
+            for (uint32_t match = group.match(h2(hash)); match; match &= match - 1) {
+                size_t index = seq.at(std::countr_zero(match));
+                if (equal_(slots_[index].first, key))
+                    return index;
+            }
+            if (group.matchEmpty())
+                return capacity_;
+        }
+    }
+
+    // The first EMPTY or DELETED slot along the key's probe sequence
+    size_t findInsertSlot(size_t hash) const
+    {
+        for (Probe seq = probe(hash);; seq.next()) {
+            if (uint32_t free = flat::Group(ctrl_ + seq.offset).matchEmptyOrDeleted())
+                return seq.at(std::countr_zero(free));
+        }
+    }
+
+    template <typename K>
+    std::pair<size_t, bool> findOrPrepareInsert(const K& key, size_t hash)
+    {
+        size_t index = findIndex(key, hash);
+        if (index != capacity_)
+            return { index, true };
+        if (growthLeft_ == 0) {
+            // Mostly tombstones: clean up in place rather than doubling
+            resize(size_ < maxLoad(capacity_) / 2 ? capacity_ : capacityFor(size_ + 1));
+        }
+        return { findInsertSlot(hash), false };
+    }
+
+    void commitInsert(size_t index, size_t hash)
+    {
+        if (ctrl_[index] == flat::EMPTY)
+            --growthLeft_;
+        setCtrl(index, h2(hash));
+        ++size_;
+    }
+
+    // The first GROUP_WIDTH - 1 bytes are mirrored past the end, so a group
+    // that starts near the end reads the wrapped-around bytes in one load
+    void setCtrl(size_t index, flat::Ctrl value)
+    {
+        ctrl_[index] = value;
+        if (index < flat::GROUP_WIDTH - 1)
+            ctrl_[capacity_ + index] = value;
+    }
+
+    void resize(size_t capacity)
+    {
+        flat::Ctrl* oldCtrl = ctrl_;
+        value_type* oldSlots = slots_;
+        size_t oldCapacity = capacity_;
+
+        ctrl_ = new flat::Ctrl[capacity + flat::GROUP_WIDTH - 1];
+        std::memset(ctrl_, flat::EMPTY, capacity + flat::GROUP_WIDTH - 1);
+        slots_ = std::allocator<value_type>().allocate(capacity);
+        capacity_ = capacity;
+        growthLeft_ = maxLoad(capacity) - size_;
+
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (oldCtrl[i] < 0)
+                continue;
+            size_t hash = hasher_(oldSlots[i].first);
+            size_t index = findInsertSlot(hash);
+            std::construct_at(&slots_[index], std::move(oldSlots[i]));
+            std::destroy_at(&oldSlots[i]);
+            setCtrl(index, h2(hash));
+        }
+        delete[] oldCtrl;
+        if (oldSlots)
+            std::allocator<value_type>().deallocate(oldSlots, oldCapacity);
+    }
+
+    void release()
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0)
+                std::destroy_at(&slots_[i]);
+        }
+        delete[] ctrl_;
+        if (slots_)
+            std::allocator<value_type>().deallocate(slots_, capacity_);
+    }
+
+    flat::Ctrl* ctrl_ = nullptr;
+    value_type* slots_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    size_t growthLeft_ = 0;
+    [[no_unique_address]] Hash hasher_;
+    [[no_unique_address]] Equal equal_;
+};
+
+} // namespace storage
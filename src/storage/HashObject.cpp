@@ -0,0 +1,99 @@
+#include "HashObject.h"
+
+namespace storage {
+
+HashObject::HashObject(const HashObject& other)
+    : pack_(other.pack_)
+    , table_(other.table_ ? std::make_unique<Table>(*other.table_) : nullptr)
+{
+}
+
+HashObject& HashObject::operator=(HashObject other) noexcept
+{
+    std::swap(pack_, other.pack_);
+    std::swap(table_, other.table_);
+    return *this;
+}
+
+bool HashObject::set(std::string_view field, std::string_view value, const EncodingLimits& limits)
+{
+    if (!table_) {
+        if (auto pos = find(field); pos != pack_.end()) {
+            if (value.size() <= limits.hashMaxListpackValue) {
+                pack_.replace(pack_.next(pos), value);
+                return false;
+            }
+        } else if (size() < limits.hashMaxListpackEntries && field.size() <= limits.hashMaxListpackValue
+            && value.size() <= limits.hashMaxListpackValue) {
+            pack_.pushBack(field);
+            pack_.pushBack(value);
+            return true;
+        }
+        convert();
+    }
+    auto it = table_->find(field);
+    if (it != table_->end()) {
+        it->second = value;
+        return false;
+    }
+    table_->emplace(std::string(field), std::string(value));
+    return true;
+}
+
+std::optional<std::string_view> HashObject::get(std::string_view field) const
+{
+    if (table_) {
+        auto it = table_->find(field);
+        if (it == table_->end())
+            return std::nullopt;
+        return std::string_view(it->second);
+    }
+    auto pos = find(field);
+    if (pos == pack_.end())
+        return std::nullopt;
+    return pack_.at(pack_.next(pos));
+}
+
+bool HashObject::erase(std::string_view field)
+{
+    if (table_) {
+        auto it = table_->find(field);
+        if (it == table_->end())
+            return false;
+        table_->erase(it);
+        return true;
+    }
+    auto pos = find(field);
+    if (pos == pack_.end())
+        return false;
+    pack_.erase(pack_.erase(pos));
+    return true;
+}
+
+void HashObject::reserve(size_t count, const EncodingLimits& limits)
+{
+    if (!table_ && count > limits.hashMaxListpackEntries)
+        convert();
+    if (table_)
+        table_->reserve(count);
+}
+
+ListPack::Position HashObject::find(std::string_view field) const
+{
+    for (auto pos = pack_.begin(); pos != pack_.end(); pos = pack_.next(pack_.next(pos))) {
+        if (pack_.at(pos) == field)
+            return pos;
+    }
+    return pack_.end();
+}
+
+void HashObject::convert()
+{
+    auto table = std::make_unique<Table>();
+    table->reserve(size() + 1);
+    forEach([&](std::string_view field, std::string_view value) { table->emplace(field, value); });
+    table_ = std::move(table);
+    pack_ = ListPack();
+}
+
+} // namespace storage
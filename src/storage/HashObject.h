@@ -0,0 +1,61 @@
+#pragma once
+
+#include "EncodingLimits.h"
+#include "ListPack.h"
+#include "StringHash.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace storage {
+
+// A hash value. Small hashes are a ListPack of alternating fields and
+// values, searched linearly; past the EncodingLimits they move into a hash
+// table for good.
+class HashObject {
+public:
+    using Table = std::unordered_map<std::string, std::string, StringHash, std::equal_to<>>;
+
+    HashObject() = default;
+    HashObject(const HashObject& other);
+    HashObject(HashObject&&) noexcept = default;
+    HashObject& operator=(HashObject other) noexcept;
+
+    size_t size() const { return table_ ? table_->size() : pack_.size() / 2; }
+    bool empty() const { return size() == 0; }
+    // "listpack" or "hashtable"
+    const char* encoding() const { return table_ ? "hashtable" : "listpack"; }
+
+    // Returns true if field is new
+    bool set(std::string_view field, std::string_view value, const EncodingLimits& limits);
+    // The view is good until the hash next changes
+    std::optional<std::string_view> get(std::string_view field) const;
+    bool erase(std::string_view field);
+    // Makes room for count fields in all, converting now if that many
+    // would pass the entry limit
+    void reserve(size_t count, const EncodingLimits& limits);
+
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        if (table_) {
+            for (const auto& [field, value] : *table_)
+                fn(std::string_view(field), std::string_view(value));
+            return;
+        }
+        for (auto pos = pack_.begin(); pos != pack_.end(); pos = pack_.next(pack_.next(pos)))
+            fn(pack_.at(pos), pack_.at(pack_.next(pos)));
+    }
+
+private:
+    // Position of field's entry in pack_, or pack_.end()
+    ListPack::Position find(std::string_view field) const;
+    void convert();
+
+    ListPack pack_;
+    std::unique_ptr<Table> table_; // Set once converted; pack_ is empty then
+};
+
+} // namespace storage
@@ -0,0 +1,139 @@
+#include "IntSet.h"
+
+#include <cstring>
+#include <limits>
+
+namespace storage {
+
+namespace {
+    template <typename T>
+    T load(const char* in)
+    {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void store(char* out, int64_t value)
+    {
+        T narrowed = static_cast<T>(value);
+        std::memcpy(out, &narrowed, sizeof(T));
+    }
+
+    template <typename T>
+    size_t lowerBoundOf(const char* data, size_t count, int64_t value)
+    {
+        size_t low = 0;
+        while (count > 0) {
+            size_t half = count / 2;
+            if (load<T>(data + (low + half) * sizeof(T)) < value) {
+                low += half + 1;
+                count -= half + 1;
+            } else {
+                count = half;
+            }
+        }
+        return low;
+    }
+} // namespace
+
+size_t IntSet::widthFor(int64_t value)
+{
+    if (value >= std::numeric_limits<int16_t>::min() && value <= std::numeric_limits<int16_t>::max())
+        return sizeof(int16_t);
+    if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max())
+        return sizeof(int32_t);
+    return sizeof(int64_t);
+}
+
+int64_t IntSet::at(size_t index) const
+{
+    const char* in = data_.data() + index * width_;
+    switch (width_) {
+    case sizeof(int16_t):
+        return load<int16_t>(in);
+    case sizeof(int32_t):
+        return load<int32_t>(in);
+    default:
+        return load<int64_t>(in);
+    }
+}
+
+void IntSet::set(size_t index, int64_t value)
+{
+    char* out = data_.data() + index * width_;
+    switch (width_) {
+    case sizeof(int16_t):
+        store<int16_t>(out, value);
+        break;
+    case sizeof(int32_t):
+        store<int32_t>(out, value);
+        break;
+    default:
+        store<int64_t>(out, value);
+        break;
+    }
+}
+
+size_t IntSet::lowerBound(int64_t value, size_t from) const
+{
+    const char* data = data_.data() + from * width_;
+    switch (width_) {
+    case sizeof(int16_t):
+        return from + lowerBoundOf<int16_t>(data, size() - from, value);
+    case sizeof(int32_t):
+        return from + lowerBoundOf<int32_t>(data, size() - from, value);
+    default:
+        return from + lowerBoundOf<int64_t>(data, size() - from, value);
+    }
+}
+
+bool IntSet::contains(int64_t value) const
+{
+    if (widthFor(value) > width_)
+        return false;
+    size_t index = lowerBound(value);
+    return index < size() && at(index) == value;
+}
+
+bool IntSet::insert(int64_t value)
+{
+    size_t index;
+    if (widthFor(value) > width_) {
+        // Too wide for every element here, so it goes at one end
+        index = value < 0 ? 0 : size();
+        widen(widthFor(value));
+    } else {
+        index = lowerBound(value);
+        if (index < size() && at(index) == value)
+            return false;
+    }
+    data_.insert(index * width_, width_, '\0');
+    set(index, value);
+    return true;
+}
+
+bool IntSet::erase(int64_t value)
+{
+    if (widthFor(value) > width_)
+        return false;
+    size_t index = lowerBound(value);
+    if (index == size() || at(index) != value)
+        return false;
+    data_.erase(index * width_, width_);
+    return true;
+}
+
+void IntSet::widen(size_t width)
+{
+    size_t count = size();
+    IntSet wider;
+    wider.width_ = static_cast<uint8_t>(width);
+    wider.data_.resize(count * width);
+    for (size_t i = 0; i < count; ++i)
+        wider.set(i, at(i));
+    *this = std::move(wider);
+}
+
+} // namespace storage
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace storage {
+
+// A set of integers as one sorted array, after Redis's intset. Every element
+// has the width of the widest one, 2, 4 or 8 bytes, so a set of small IDs
+// costs two bytes a member; a value that doesn't fit widens the whole array
+// once. Lookups are a binary search; inserting or erasing moves the elements
+// behind the position, so an IntSet is capped by EncodingLimits. Set members
+// map to and from it through parseCanonicalInteger() and formatInteger().
+class IntSet {
+public:
+    size_t size() const { return data_.size() / width_; }
+    bool empty() const { return data_.empty(); }
+    size_t bytes() const { return data_.size(); }
+    // Bytes per element
+    size_t width() const { return width_; }
+
+    bool contains(int64_t value) const;
+    // Returns true if value is new
+    bool insert(int64_t value);
+    bool erase(int64_t value);
+    // Elements ascend with index
+    int64_t at(size_t index) const;
+    // Index of the first element from index from on that is not less than
+    // value, or size()
+    size_t lowerBound(int64_t value, size_t from = 0) const;
+
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (size_t i = 0, n = size(); i < n; ++i)
+            fn(at(i));
+    }
+
+private:
+    static size_t widthFor(int64_t value);
+    void set(size_t index, int64_t value);
+    void widen(size_t width);
+
+    std::string data_;
+    uint8_t width_ = sizeof(int16_t);
+};
+
+} // namespace storage
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace storage {
+
+// Longest decimal int64_t, "-9223372036854775808"
+constexpr size_t MAX_INTEGER_CHARS = 20;
+
+// The value of a string the store may keep as an integer instead: a decimal
+// int64_t in canonical form, so it prints back as the same string. "007",
+// "+7" and "-0" stay strings.
+inline std::optional<int64_t> parseCanonicalInteger(std::string_view str)
+{
+    if (str.empty() || str.size() > MAX_INTEGER_CHARS)
+        return std::nullopt;
+    int64_t value;
+    auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec != std::errc() || end != str.data() + str.size())
+        return std::nullopt;
+    char canonical[MAX_INTEGER_CHARS];
+    auto printed = std::to_chars(canonical, canonical + sizeof(canonical), value).ptr;
+    if (str != std::string_view(canonical, printed - canonical))
+        return std::nullopt;
+    return value;
+}
+
+// buffer must hold MAX_INTEGER_CHARS; the view points into it
+inline std::string_view formatInteger(int64_t value, char* buffer)
+{
+    auto end = std::to_chars(buffer, buffer + MAX_INTEGER_CHARS, value).ptr;
+    return { buffer, static_cast<size_t>(end - buffer) };
+}
+
+} // namespace storage
@@ -1,70 +1,237 @@
 #include "KeyValueStore.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 
 namespace storage {
 
+namespace {
+    std::vector<std::string> members(const RedisSet& set)
+    {
+        std::vector<std::string> result;
+        result.reserve(set.size());
+        set.forEach([&](std::string_view member) { result.emplace_back(member); });
+        return result;
+    }
+} // namespace
+
 // String operations
-void KeyValueStore::set(const std::string& key, const std::string& value)
+void KeyValueStore::set(std::string_view key, std::string_view value)
 {
-    store_[key] = RedisString(value);
+    store_.try_emplace(key).first->setString(value);
 }
 
-std::string KeyValueStore::get(const std::string& key)
+Result<std::string> KeyValueStore::get(std::string_view key)
 {
-    auto it = store_.find(key);
-    if (it == store_.end() || !std::holds_alternative<RedisString>(it->second))
-        throw std::runtime_error("Key not found or wrong type");
-    return std::get<RedisString>(it->second);
+    auto str = lookupString(key);
+    if (!str)
+        return str.error();
+    return (*str)->string();
 }
 
-bool KeyValueStore::del(const std::string& key)
+bool KeyValueStore::del(std::string_view key)
 {
     return store_.erase(key) > 0;
 }
 
-bool KeyValueStore::exists(const std::string& key)
+bool KeyValueStore::exists(std::string_view key)
+{
+    return store_.find(key) != nullptr;
+}
+
+size_t KeyValueStore::del(std::span<const std::string_view> keys)
+{
+    size_t deleted = 0;
+    for (std::string_view key : keys)
+        deleted += store_.erase(key);
+    return deleted;
+}
+
+size_t KeyValueStore::exists(std::span<const std::string_view> keys)
+{
+    size_t found = 0;
+    for (std::string_view key : keys)
+        found += store_.find(key) != nullptr;
+    return found;
+}
+
+std::vector<std::optional<std::string>> KeyValueStore::mget(std::span<const std::string_view> keys)
+{
+    std::vector<std::optional<std::string>> values;
+    values.reserve(keys.size());
+    for (std::string_view key : keys) {
+        auto str = lookupString(key);
+        if (str)
+            values.emplace_back((*str)->string());
+        else
+            values.emplace_back();
+    }
+    return values;
+}
+
+void KeyValueStore::mset(std::span<const std::string_view> keysAndValues)
+{
+    for (size_t i = 0; i + 1 < keysAndValues.size(); i += 2)
+        set(keysAndValues[i], keysAndValues[i + 1]);
+}
+
+Result<int64_t> KeyValueStore::incrby(std::string_view key, int64_t delta)
+{
+    auto found = stringFor(key);
+    if (!found)
+        return found.error();
+    RedisObject& value = **found;
+    int64_t current = 0;
+    if (value.type() == RedisObject::Type::String) {
+        auto integer = value.integer();
+        if (!integer)
+            return StoreError::NotNumber;
+        current = *integer;
+    }
+    int64_t result;
+    if (__builtin_add_overflow(current, delta, &result))
+        return StoreError::OutOfRange;
+    value.setInteger(result);
+    return result;
+}
+
+Result<std::string> KeyValueStore::incrbyfloat(std::string_view key, long double delta)
+{
+    // Checked first so a failure never leaves a new key behind
+    if (!std::isfinite(delta))
+        return StoreError::OutOfRange;
+    auto found = stringFor(key);
+    if (!found)
+        return found.error();
+    RedisObject& value = **found;
+    long double current = 0;
+    if (value.type() == RedisObject::Type::String) {
+        std::string text = value.string();
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), current);
+        if (ec != std::errc() || end != text.data() + text.size() || text.empty() || std::isnan(current))
+            return StoreError::NotNumber;
+    }
+    long double result = current + delta;
+    if (!std::isfinite(result))
+        return StoreError::OutOfRange;
+    // Never an exponent, and the extra precision of long double rounded
+    // off in the last decimals rather than printed
+    char buffer[5000];
+    auto end = std::to_chars(buffer, buffer + sizeof(buffer), result, std::chars_format::fixed, 17).ptr;
+    std::string_view text(buffer, end - buffer);
+    text = text.substr(0, text.find_last_not_of('0') + 1);
+    if (text.back() == '.')
+        text.remove_suffix(1);
+    if (text == "-0")
+        text = "0";
+    value.setString(text);
+    return std::string(text);
+}
+
+Result<size_t> KeyValueStore::append(std::string_view key, std::string_view suffix)
+{
+    auto found = stringFor(key);
+    if (!found)
+        return found.error();
+    RedisObject& value = **found;
+    if (value.type() != RedisObject::Type::String) {
+        value.setString(suffix);
+        return suffix.size();
+    }
+    std::string appended = value.string();
+    appended += suffix;
+    value.setString(appended);
+    return appended.size();
+}
+
+Result<size_t> KeyValueStore::strlen(std::string_view key)
 {
-    return store_.find(key) != store_.end();
+    auto str = lookupString(key);
+    if (!str)
+        return str.error();
+    return (*str)->stringSize();
 }
 
 // List operations
-size_t KeyValueStore::lpush(const std::string& key, const std::string& value)
+size_t KeyValueStore::lpush(std::string_view key, std::span<const std::string_view> values)
 {
     auto& list = getOrCreate<RedisList>(key);
-    list.insert(list.begin(), value);
+    list.pushFront(values, limits_);
     return list.size();
 }
 
-size_t KeyValueStore::rpush(const std::string& key, const std::string& value)
+size_t KeyValueStore::rpush(std::string_view key, std::span<const std::string_view> values)
 {
     auto& list = getOrCreate<RedisList>(key);
-    list.push_back(value);
+    list.pushBack(values, limits_);
     return list.size();
 }
 
-std::string KeyValueStore::lpop(const std::string& key)
+Result<std::string> KeyValueStore::lpop(std::string_view key)
 {
-    auto& list = getOrThrow<RedisList>(key);
+    auto found = lookup<RedisList>(key);
+    if (!found)
+        return found.error();
+    auto& list = **found;
     if (list.empty())
-        throw std::runtime_error("List is empty");
-    std::string val = list.front();
-    list.erase(list.begin());
+        return StoreError::NoKey;
+    std::string val = list.popFront();
+    if (list.empty())
+        store_.erase(key);
     return val;
 }
 
-std::string KeyValueStore::rpop(const std::string& key)
+Result<std::string> KeyValueStore::rpop(std::string_view key)
 {
-    auto& list = getOrThrow<RedisList>(key);
+    auto found = lookup<RedisList>(key);
+    if (!found)
+        return found.error();
+    auto& list = **found;
+    if (list.empty())
+        return StoreError::NoKey;
+    std::string val = list.popBack();
     if (list.empty())
-        throw std::runtime_error("List is empty");
-    std::string val = list.back();
-    list.pop_back();
+        store_.erase(key);
     return val;
 }
 
-std::vector<std::string> KeyValueStore::lrange(const std::string& key, int start, int stop)
+Result<std::vector<std::string>> KeyValueStore::lpop(std::string_view key, size_t count)
+{
+    auto found = lookup<RedisList>(key);
+    if (!found)
+        return found.error();
+    auto& list = **found;
+    std::vector<std::string> values;
+    values.reserve(std::min(count, list.size()));
+    while (values.size() < count && !list.empty())
+        values.push_back(list.popFront());
+    if (list.empty())
+        store_.erase(key);
+    return values;
+}
+
+Result<std::vector<std::string>> KeyValueStore::rpop(std::string_view key, size_t count)
 {
-    auto& list = getOrThrow<RedisList>(key);
-    int size = static_cast<int>(list.size());
+    auto found = lookup<RedisList>(key);
+    if (!found)
+        return found.error();
+    auto& list = **found;
+    std::vector<std::string> values;
+    values.reserve(std::min(count, list.size()));
+    while (values.size() < count && !list.empty())
+        values.push_back(list.popBack());
+    if (list.empty())
+        store_.erase(key);
+    return values;
+}
+
+Result<std::vector<std::string>> KeyValueStore::lrange(std::string_view key, long long start, long long stop)
+{
+    auto found = lookup<RedisList>(key);
+    if (!found)
+        return found.error();
+    auto& list = **found;
+    long long size = static_cast<long long>(list.size());
     if (start < 0)
         start += size;
     if (stop < 0)
@@ -74,98 +241,208 @@ std::vector<std::string> KeyValueStore::lrange(const std::string& key, int start
     if (stop >= size)
         stop = size - 1;
     if (start > stop || start >= size)
-        return {};
-    return std::vector<std::string> { list.begin() + start, list.begin() + stop + 1 };
+        return std::vector<std::string> {};
+    std::vector<std::string> result;
+    result.reserve(stop - start + 1);
+    list.forEachInRange(start, stop, [&](std::string_view value) { result.emplace_back(value); });
+    return result;
 }
 
 // Set operations
-size_t KeyValueStore::sadd(const std::string& key, const std::string& member)
+size_t KeyValueStore::sadd(std::string_view key, std::span<const std::string_view> members)
 {
     auto& set = getOrCreate<RedisSet>(key);
-    size_t curr_size = set.size();
-    auto [_, inserted] = set.insert(member);
-    return set.size() - curr_size;
+    if (members.size() > 1)
+        set.reserve(set.size() + members.size(), limits_);
+    size_t added = 0;
+    for (std::string_view member : members)
+        added += set.add(member, limits_);
+    return added;
+}
+
+Result<size_t> KeyValueStore::srem(std::string_view key, std::span<const std::string_view> members)
+{
+    auto found = lookup<RedisSet>(key);
+    if (!found)
+        return found.error();
+    size_t removed = 0;
+    for (std::string_view member : members)
+        removed += (*found)->remove(member);
+    if ((*found)->empty())
+        store_.erase(key);
+    return removed;
+}
+
+Result<bool> KeyValueStore::sismember(std::string_view key, std::string_view member)
+{
+    auto set = lookup<RedisSet>(key);
+    if (!set)
+        return set.error();
+    return (*set)->contains(member);
+}
+
+Result<std::vector<std::string>> KeyValueStore::smembers(std::string_view key)
+{
+    auto set = lookup<RedisSet>(key);
+    if (!set)
+        return set.error();
+    return members(**set);
+}
+
+Result<std::vector<std::string>> KeyValueStore::sinter(std::span<const std::string_view> keys)
+{
+    auto sets = peekSets(keys);
+    if (!sets)
+        return sets.error();
+    return members(RedisSet::intersectionOf(*sets, limits_));
+}
+
+Result<std::vector<std::string>> KeyValueStore::sunion(std::span<const std::string_view> keys)
+{
+    auto sets = peekSets(keys);
+    if (!sets)
+        return sets.error();
+    return members(RedisSet::unionOf(*sets, limits_));
+}
+
+Result<std::vector<std::string>> KeyValueStore::sdiff(std::span<const std::string_view> keys)
+{
+    auto sets = peekSets(keys);
+    if (!sets)
+        return sets.error();
+    return members(RedisSet::differenceOf(*sets, limits_));
 }
 
-size_t KeyValueStore::srem(const std::string& key, const std::string& member)
+Result<size_t> KeyValueStore::sintercard(std::span<const std::string_view> keys, size_t limit)
 {
-    auto& set = getOrThrow<RedisSet>(key);
-    std::size_t curr_size = set.size();
-    set.erase(member);
-    return curr_size - set.size();
+    auto sets = peekSets(keys);
+    if (!sets)
+        return sets.error();
+    return RedisSet::intersectionOf(*sets, limits_, limit).size();
 }
 
-std::unordered_set<std::string> KeyValueStore::smembers(const std::string& key)
+Result<size_t> KeyValueStore::sinterstore(std::string_view destination, std::span<const std::string_view> keys)
 {
-    auto& set = getOrThrow<RedisSet>(key);
-    return set;
+    auto sets = peekSets(keys);
+    if (!sets)
+        return sets.error();
+    return storeSet(destination, RedisSet::intersectionOf(*sets, limits_));
+}
+
+Result<size_t> KeyValueStore::sunionstore(std::string_view destination, std::span<const std::string_view> keys)
+{
+    auto sets = peekSets(keys);
+    if (!sets)
+        return sets.error();
+    return storeSet(destination, RedisSet::unionOf(*sets, limits_));
+}
+
+Result<size_t> KeyValueStore::sdiffstore(std::string_view destination, std::span<const std::string_view> keys)
+{
+    auto sets = peekSets(keys);
+    if (!sets)
+        return sets.error();
+    return storeSet(destination, RedisSet::differenceOf(*sets, limits_));
 }
 
 // Hash operations
-bool KeyValueStore::hset(const std::string& key, const std::string& field, const std::string& value)
+size_t KeyValueStore::hset(std::string_view key, std::span<const std::string_view> fieldsAndValues)
 {
     auto& hash = getOrCreate<RedisHash>(key);
-    bool is_new = hash.find(field) == hash.end();
-    hash[field] = value;
-    return is_new;
+    size_t pairs = fieldsAndValues.size() / 2;
+    if (pairs > 1)
+        hash.reserve(hash.size() + pairs, limits_);
+    size_t added = 0;
+    for (size_t i = 0; i + 1 < fieldsAndValues.size(); i += 2)
+        added += hash.set(fieldsAndValues[i], fieldsAndValues[i + 1], limits_);
+    return added;
 }
 
-std::string KeyValueStore::hget(const std::string& key, const std::string& field)
+Result<std::string> KeyValueStore::hget(std::string_view key, std::string_view field)
 {
-    auto& hash = getOrThrow<RedisHash>(key);
-    auto it = hash.find(field);
-    if (it == hash.end())
-        throw std::runtime_error("Field not found");
-    return it->second;
+    auto hash = lookup<RedisHash>(key);
+    if (!hash)
+        return hash.error();
+    auto value = (*hash)->get(field);
+    if (!value)
+        return StoreError::NoKey;
+    return std::string(*value);
+}
+
+Result<std::vector<std::optional<std::string>>> KeyValueStore::hmget(std::string_view key,
+    std::span<const std::string_view> fields)
+{
+    auto hash = lookup<RedisHash>(key);
+    if (!hash && hash.error() != StoreError::NoKey)
+        return hash.error();
+    std::vector<std::optional<std::string>> values;
+    values.reserve(fields.size());
+    for (std::string_view field : fields) {
+        auto value = hash ? (*hash)->get(field) : std::nullopt;
+        if (value)
+            values.emplace_back(*value);
+        else
+            values.emplace_back();
+    }
+    return values;
 }
 
-bool KeyValueStore::hdel(const std::string& key, const std::string& field)
+Result<size_t> KeyValueStore::hdel(std::string_view key, std::span<const std::string_view> fields)
 {
-    auto& hash = getOrThrow<RedisHash>(key);
-    return hash.erase(field) > 0;
+    auto hash = lookup<RedisHash>(key);
+    if (!hash)
+        return hash.error();
+    size_t deleted = 0;
+    for (std::string_view field : fields)
+        deleted += (*hash)->erase(field);
+    if ((*hash)->empty())
+        store_.erase(key);
+    return deleted;
 }
 
-std::unordered_map<std::string, std::string> KeyValueStore::hgetall(const std::string& key)
+Result<std::vector<std::pair<std::string, std::string>>> KeyValueStore::hgetall(std::string_view key)
 {
-    auto& hash = getOrThrow<RedisHash>(key);
-    return hash;
+    auto hash = lookup<RedisHash>(key);
+    if (!hash)
+        return hash.error();
+    std::vector<std::pair<std::string, std::string>> entries;
+    entries.reserve((*hash)->size());
+    (*hash)->forEach([&](std::string_view field, std::string_view value) { entries.emplace_back(field, value); });
+    return entries;
 }
 
 // Sorted Set operations
-size_t KeyValueStore::zadd(const std::string& key, double score, const std::string& member)
+size_t KeyValueStore::zadd(std::string_view key, std::span<const std::pair<double, std::string_view>> entries)
 {
     auto& zset = getOrCreate<RedisZSet>(key);
-    std::size_t curr_size = zset.size();
-    // Remove existing member if present
-    for (auto it = zset.begin(); it != zset.end();) {
-        if (it->second == member)
-            it = zset.erase(it);
-        else
-            ++it;
-    }
-    zset.emplace(score, member);
-    return zset.size() - curr_size;
+    if (entries.size() > 1)
+        zset.reserve(zset.size() + entries.size());
+    size_t added = 0;
+    for (const auto& [score, member] : entries)
+        added += zset.insert(member, score);
+    return added;
 }
 
-size_t KeyValueStore::zrem(const std::string& key, const std::string& member)
+Result<size_t> KeyValueStore::zrem(std::string_view key, std::span<const std::string_view> members)
 {
-    auto& zset = getOrThrow<RedisZSet>(key);
+    auto found = lookup<RedisZSet>(key);
+    if (!found)
+        return found.error();
     size_t removed = 0;
-    for (auto it = zset.begin(); it != zset.end();) {
-        if (it->second == member) {
-            it = zset.erase(it);
-            ++removed;
-        } else {
-            ++it;
-        }
-    }
+    for (std::string_view member : members)
+        removed += (*found)->erase(member);
+    if ((*found)->empty())
+        store_.erase(key);
     return removed;
 }
 
-std::vector<std::string> KeyValueStore::zrange(const std::string& key, int start, int stop)
+Result<std::vector<ScoredMember>> KeyValueStore::zrange(std::string_view key, long long start, long long stop, bool reverse)
 {
-    auto& zset = getOrThrow<RedisZSet>(key);
-    int size = static_cast<int>(zset.size());
+    auto found = lookup<RedisZSet>(key);
+    if (!found)
+        return found.error();
+    auto& zset = **found;
+    long long size = static_cast<long long>(zset.size());
     if (start < 0)
         start += size;
     if (stop < 0)
@@ -175,49 +452,178 @@ std::vector<std::string> KeyValueStore::zrange(const std::string& key, int start
     if (stop >= size)
         stop = size - 1;
     if (start > stop || start >= size)
-        return {};
-    std::vector<std::string> result;
-    int idx = 0;
-    for (const auto& [score, member] : zset) {
-        if (idx >= start && idx <= stop)
-            result.push_back(member);
-        if (idx > stop)
-            break;
-        ++idx;
-    }
+        return std::vector<ScoredMember> {};
+    std::vector<ScoredMember> result;
+    result.reserve(stop - start + 1);
+    zset.forEachInRank(start, stop, reverse, [&](std::string_view member, double score) {
+        result.push_back({ std::string(member), score });
+    });
     return result;
 }
 
+Result<std::vector<ScoredMember>> KeyValueStore::zrangebyscore(std::string_view key, const ScoreRange& range, size_t offset,
+    size_t count)
+{
+    auto found = lookup<RedisZSet>(key);
+    if (!found)
+        return found.error();
+    auto& zset = **found;
+    auto [first, last] = zset.rankRange(range);
+    if (offset >= last - first || count == 0)
+        return std::vector<ScoredMember> {};
+    first += offset;
+    last = std::min(last, first + std::min(count, last - first));
+    std::vector<ScoredMember> result;
+    result.reserve(last - first);
+    zset.forEachInRank(first, last - 1, false, [&](std::string_view member, double score) {
+        result.push_back({ std::string(member), score });
+    });
+    return result;
+}
+
+Result<size_t> KeyValueStore::zcount(std::string_view key, const ScoreRange& range)
+{
+    auto found = lookup<RedisZSet>(key);
+    if (!found)
+        return found.error();
+    auto [first, last] = (*found)->rankRange(range);
+    return last - first;
+}
+
+Result<double> KeyValueStore::zscore(std::string_view key, std::string_view member)
+{
+    auto found = lookup<RedisZSet>(key);
+    if (!found)
+        return found.error();
+    auto score = (*found)->score(member);
+    if (!score)
+        return StoreError::NoKey;
+    return *score;
+}
+
+Result<size_t> KeyValueStore::zrank(std::string_view key, std::string_view member, bool reverse)
+{
+    auto found = lookup<RedisZSet>(key);
+    if (!found)
+        return found.error();
+    auto rank = (*found)->rank(member);
+    if (!rank)
+        return StoreError::NoKey;
+    return reverse ? (*found)->size() - 1 - *rank : *rank;
+}
+
+Result<double> KeyValueStore::zincrby(std::string_view key, double delta, std::string_view member)
+{
+    RedisObject& value = *store_.try_emplace(key).first;
+    if (value.type() != RedisObject::Type::ZSet && value.type() != RedisObject::Type::None)
+        return StoreError::WrongType;
+    RedisZSet* existing = value.get_if<RedisZSet>();
+    auto& zset = existing ? *existing : value.emplace<RedisZSet>();
+    auto score = zset.incrementBy(member, delta);
+    if (zset.empty())
+        store_.erase(key);
+    if (!score)
+        return StoreError::OutOfRange;
+    return *score;
+}
+
+Result<const char*> KeyValueStore::encoding(std::string_view key)
+{
+    RedisObject* value = store_.find(key);
+    if (!value)
+        return StoreError::NoKey;
+    return value->encoding();
+}
+
+bool KeyValueStore::rehashFor(std::chrono::microseconds budget)
+{
+    return store_.rehashFor(budget);
+}
+
 // Helpers
 template <typename T>
-T& KeyValueStore::getOrCreate(const std::string& key)
+T& KeyValueStore::getOrCreate(std::string_view key)
 {
-    auto it = store_.find(key);
-    if (it == store_.end() || !std::holds_alternative<T>(it->second)) {
-        store_[key] = T();
-    }
-    return std::get<T>(store_[key]);
+    RedisObject* value = store_.try_emplace(key).first;
+    if (T* existing = value->get_if<T>())
+        return *existing;
+    return value->emplace<T>();
+}
+
+template <typename T>
+Result<T*> KeyValueStore::lookup(std::string_view key)
+{
+    RedisObject* found = store_.find(key);
+    if (!found)
+        return StoreError::NoKey;
+    T* value = found->get_if<T>();
+    if (!value)
+        return StoreError::WrongType;
+    return value;
+}
+
+Result<RedisObject*> KeyValueStore::stringFor(std::string_view key)
+{
+    RedisObject& value = *store_.try_emplace(key).first;
+    auto type = value.type();
+    if (type != RedisObject::Type::String && type != RedisObject::Type::None)
+        return StoreError::WrongType;
+    return &value;
+}
+
+Result<RedisObject*> KeyValueStore::lookupString(std::string_view key)
+{
+    RedisObject* found = store_.find(key);
+    if (!found)
+        return StoreError::NoKey;
+    if (found->type() != RedisObject::Type::String)
+        return StoreError::WrongType;
+    return found;
 }
 
 template <typename T>
-T& KeyValueStore::getOrThrow(const std::string& key)
+Result<const T*> KeyValueStore::peek(std::string_view key) const
+{
+    const RedisObject* found = store_.find(key);
+    if (!found)
+        return nullptr;
+    const T* value = found->get_if<T>();
+    if (!value)
+        return StoreError::WrongType;
+    return value;
+}
+
+Result<std::vector<const RedisSet*>> KeyValueStore::peekSets(std::span<const std::string_view> keys) const
+{
+    std::vector<const RedisSet*> sets;
+    sets.reserve(keys.size());
+    for (std::string_view key : keys) {
+        auto set = peek<RedisSet>(key);
+        if (!set)
+            return set.error();
+        sets.push_back(*set);
+    }
+    return sets;
+}
+
+size_t KeyValueStore::storeSet(std::string_view destination, RedisSet set)
 {
-    auto it = store_.find(key);
-    if (it == store_.end() || !std::holds_alternative<T>(it->second))
-        throw std::runtime_error("Key not found or wrong type");
-    return std::get<T>(it->second);
+    size_t size = set.size();
+    if (size == 0)
+        store_.erase(destination);
+    else
+        getOrCreate<RedisSet>(destination) = std::move(set);
+    return size;
 }
 
-template RedisString& KeyValueStore::getOrCreate<RedisString>(const std::string&);
-template RedisList& KeyValueStore::getOrCreate<RedisList>(const std::string&);
-template RedisSet& KeyValueStore::getOrCreate<RedisSet>(const std::string&);
-template RedisHash& KeyValueStore::getOrCreate<RedisHash>(const std::string&);
-template RedisZSet& KeyValueStore::getOrCreate<RedisZSet>(const std::string&);
+template RedisList& KeyValueStore::getOrCreate<RedisList>(std::string_view);
+template RedisSet& KeyValueStore::getOrCreate<RedisSet>(std::string_view);
+template RedisHash& KeyValueStore::getOrCreate<RedisHash>(std::string_view);
+template RedisZSet& KeyValueStore::getOrCreate<RedisZSet>(std::string_view);
 
-template RedisString& KeyValueStore::getOrThrow<RedisString>(const std::string&);
-template RedisList& KeyValueStore::getOrThrow<RedisList>(const std::string&);
-template RedisSet& KeyValueStore::getOrThrow<RedisSet>(const std::string&);
-template RedisHash& KeyValueStore::getOrThrow<RedisHash>(const std::string&);
-template RedisZSet& KeyValueStore::getOrThrow<RedisZSet>(const std::string&);
+template Result<RedisList*> KeyValueStore::lookup<RedisList>(std::string_view);
+template Result<RedisSet*> KeyValueStore::lookup<RedisSet>(std::string_view);
+template Result<RedisHash*> KeyValueStore::lookup<RedisHash>(std::string_view);
+template Result<RedisZSet*> KeyValueStore::lookup<RedisZSet>(std::string_view);
 
 }; // namespace storage
\ No newline at end of file
@@ -1,51 +1,164 @@
 #pragma once
 
+#include "Result.h"
 #include "StorageTypes.h"
-#include <stdexcept>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace storage {
 
+// Keys, fields and members are looked up through views, so a request's
+// arguments are used in place; a key is only copied when it's first stored.
+// Values are taken as views too: the store copies each into its own
+// encoding, an inline integer or string, a packed buffer or a heap copy.
+//
+// Emptying a list, set, hash or sorted set deletes its key.
+//
+// Reads report a missing key or element, or a key of another type, through
+// Result instead of throwing. Writes replace a key of another type.
 class KeyValueStore {
 public:
+    explicit KeyValueStore(EncodingLimits limits = {})
+        : limits_(limits)
+    {
+    }
+
     // String operations
-    void set(const std::string& key, const std::string& value);
-    std::string get(const std::string& key);
-    bool del(const std::string& key);
-    bool exists(const std::string& key);
-
-    // List operations
-    size_t lpush(const std::string& key, const std::string& value);
-    size_t rpush(const std::string& key, const std::string& value);
-    std::string lpop(const std::string& key);
-    std::string rpop(const std::string& key);
-    std::vector<std::string> lrange(const std::string& key, int start, int stop);
-
-    // Set operations
-    size_t sadd(const std::string& key, const std::string& member);
-    size_t srem(const std::string& key, const std::string& member);
-    std::unordered_set<std::string> smembers(const std::string& key);
-
-    // Hash operations
-    bool hset(const std::string& key, const std::string& field, const std::string& value);
-    std::string hget(const std::string& key, const std::string& field);
-    bool hdel(const std::string& key, const std::string& field);
-    std::unordered_map<std::string, std::string> hgetall(const std::string& key);
-
-    // Sorted Set operations
-    size_t zadd(const std::string& key, double score, const std::string& member);
-    size_t zrem(const std::string& key, const std::string& member);
-    std::vector<std::string> zrange(const std::string& key, int start, int stop);
+    void set(std::string_view key, std::string_view value);
+    Result<std::string> get(std::string_view key);
+    bool del(std::string_view key);
+    bool exists(std::string_view key);
+    // How many of keys were deleted, or exist; a key named twice exists twice
+    size_t del(std::span<const std::string_view> keys);
+    size_t exists(std::span<const std::string_view> keys);
+    // nullopt for a key that is missing or not a string
+    std::vector<std::optional<std::string>> mget(std::span<const std::string_view> keys);
+    // Keys alternate with their values
+    void mset(std::span<const std::string_view> keysAndValues);
+    // These read the old value, so unlike set() they leave a key of
+    // another type alone and return WrongType.
+    //
+    // A missing key counts as 0. The value must be a canonical integer,
+    // which the store keeps as an int64_t, so this neither parses nor
+    // prints. OutOfRange if the result would overflow.
+    Result<int64_t> incrby(std::string_view key, int64_t delta);
+    // Adds in long double and stores the sum with 17 decimals, trailing
+    // zeros trimmed, as Redis does: 0.1 plus 0.2 makes "0.3". Returns the
+    // new value. OutOfRange if it would be NaN or infinite.
+    Result<std::string> incrbyfloat(std::string_view key, long double delta);
+    // Returns the new length
+    Result<size_t> append(std::string_view key, std::string_view value);
+    Result<size_t> strlen(std::string_view key);
+
+    // List operations. Pushes take values in turn, so lpush leaves the last
+    // of them at the head, and return the new length.
+    size_t lpush(std::string_view key, std::span<const std::string_view> values);
+    size_t rpush(std::string_view key, std::span<const std::string_view> values);
+    size_t lpush(std::string_view key, std::string_view value) { return lpush(key, one(value)); }
+    size_t rpush(std::string_view key, std::string_view value) { return rpush(key, one(value)); }
+    Result<std::string> lpop(std::string_view key);
+    Result<std::string> rpop(std::string_view key);
+    // Up to count values, from the head or the tail
+    Result<std::vector<std::string>> lpop(std::string_view key, size_t count);
+    Result<std::vector<std::string>> rpop(std::string_view key, size_t count);
+    Result<std::vector<std::string>> lrange(std::string_view key, long long start, long long stop);
+
+    // Set operations. sadd and srem return how many members they added or
+    // removed.
+    size_t sadd(std::string_view key, std::span<const std::string_view> members);
+    Result<size_t> srem(std::string_view key, std::span<const std::string_view> members);
+    size_t sadd(std::string_view key, std::string_view member) { return sadd(key, one(member)); }
+    Result<size_t> srem(std::string_view key, std::string_view member) { return srem(key, one(member)); }
+    Result<bool> sismember(std::string_view key, std::string_view member);
+    Result<std::vector<std::string>> smembers(std::string_view key);
+    // Set algebra over keys, where a missing key is an empty set. A key of
+    // another type fails the whole operation. The store variants replace
+    // destination with the result, deleting it if the result is empty, and
+    // return the result's size.
+    Result<std::vector<std::string>> sinter(std::span<const std::string_view> keys);
+    Result<std::vector<std::string>> sunion(std::span<const std::string_view> keys);
+    Result<std::vector<std::string>> sdiff(std::span<const std::string_view> keys);
+    // Stops counting at limit
+    Result<size_t> sintercard(std::span<const std::string_view> keys, size_t limit = SIZE_MAX);
+    Result<size_t> sinterstore(std::string_view destination, std::span<const std::string_view> keys);
+    Result<size_t> sunionstore(std::string_view destination, std::span<const std::string_view> keys);
+    Result<size_t> sdiffstore(std::string_view destination, std::span<const std::string_view> keys);
+
+    // Hash operations. hset takes fields alternating with their values and
+    // returns how many fields are new; hdel returns how many it removed.
+    size_t hset(std::string_view key, std::span<const std::string_view> fieldsAndValues);
+    Result<size_t> hdel(std::string_view key, std::span<const std::string_view> fields);
+    bool hset(std::string_view key, std::string_view field, std::string_view value)
+    {
+        std::string_view pair[] = { field, value };
+        return hset(key, pair) != 0;
+    }
+    Result<size_t> hdel(std::string_view key, std::string_view field) { return hdel(key, one(field)); }
+    Result<std::string> hget(std::string_view key, std::string_view field);
+    // nullopt for each field that's missing
+    Result<std::vector<std::optional<std::string>>> hmget(std::string_view key, std::span<const std::string_view> fields);
+    Result<std::vector<std::pair<std::string, std::string>>> hgetall(std::string_view key);
+
+    // Sorted Set operations. zadd returns how many members are new, zrem
+    // how many it removed.
+    size_t zadd(std::string_view key, std::span<const std::pair<double, std::string_view>> entries);
+    Result<size_t> zrem(std::string_view key, std::span<const std::string_view> members);
+    size_t zadd(std::string_view key, double score, std::string_view member)
+    {
+        std::pair<double, std::string_view> entry { score, member };
+        return zadd(key, { &entry, 1 });
+    }
+    Result<size_t> zrem(std::string_view key, std::string_view member) { return zrem(key, one(member)); }
+    // With reverse, ranks count down from the highest score
+    Result<std::vector<ScoredMember>> zrange(std::string_view key, long long start, long long stop, bool reverse = false);
+    // Skips offset entries in range, then returns up to count
+    Result<std::vector<ScoredMember>> zrangebyscore(std::string_view key, const ScoreRange& range, size_t offset = 0,
+        size_t count = SIZE_MAX);
+    Result<size_t> zcount(std::string_view key, const ScoreRange& range);
+    Result<double> zscore(std::string_view key, std::string_view member);
+    Result<size_t> zrank(std::string_view key, std::string_view member, bool reverse = false);
+    // Reads the old score, so a key of another type is left alone and gives
+    // WrongType. OutOfRange, changing nothing, if the new score would be NaN.
+    Result<double> zincrby(std::string_view key, double delta, std::string_view member);
+
+    // How the key's value is laid out, as OBJECT ENCODING reports it
+    Result<const char*> encoding(std::string_view key);
+
+    // Moves on with a pending keyspace resize for up to budget, for callers
+    // with nothing better to do. Returns true if there's more to do.
+    bool rehashFor(std::chrono::microseconds budget);
+    bool rehashing() const { return store_.rehashing(); }
 
 private:
-    std::unordered_map<std::string, RedisVariant> store_;
+    static std::span<const std::string_view> one(const std::string_view& value) { return { &value, 1 }; }
+
+    Keyspace store_;
+    EncodingLimits limits_;
 
+    // One hash lookup whether or not the key exists
     template <typename T>
-    T& getOrCreate(const std::string& key);
+    T& getOrCreate(std::string_view key);
 
     template <typename T>
-    T& getOrThrow(const std::string& key);
+    Result<T*> lookup(std::string_view key);
+    Result<RedisObject*> lookupString(std::string_view key);
+    // The key's value if it's a string, or a new empty one for a missing
+    // key, to be set by the caller. WrongType for a key of another type.
+    Result<RedisObject*> stringFor(std::string_view key);
+    // Doesn't move any entries, so pointers from several peeks hold
+    // together. A missing key is a null pointer.
+    template <typename T>
+    Result<const T*> peek(std::string_view key) const;
+
+    Result<std::vector<const RedisSet*>> peekSets(std::span<const std::string_view> keys) const;
+    // Puts set at destination, or deletes destination if set is empty
+    size_t storeSet(std::string_view destination, RedisSet set);
 };
 
 } // namespace storage
@@ -0,0 +1,97 @@
+#include "ListObject.h"
+
+namespace storage {
+
+ListObject::ListObject(const ListObject& other)
+    : pack_(other.pack_)
+    , list_(other.list_ ? std::make_unique<QuickList>(*other.list_) : nullptr)
+{
+}
+
+ListObject& ListObject::operator=(ListObject other) noexcept
+{
+    std::swap(pack_, other.pack_);
+    std::swap(list_, other.list_);
+    return *this;
+}
+
+void ListObject::pushFront(std::string_view value, const EncodingLimits& limits)
+{
+    if (!list_ && !packFits(value, limits))
+        convert();
+    if (list_)
+        list_->pushFront(value);
+    else
+        pack_.pushFront(value);
+}
+
+void ListObject::pushBack(std::string_view value, const EncodingLimits& limits)
+{
+    if (!list_ && !packFits(value, limits))
+        convert();
+    if (list_)
+        list_->pushBack(value);
+    else
+        pack_.pushBack(value);
+}
+
+void ListObject::pushFront(std::span<const std::string_view> values, const EncodingLimits& limits)
+{
+    reserve(values, limits);
+    for (std::string_view value : values)
+        pushFront(value, limits);
+}
+
+void ListObject::pushBack(std::span<const std::string_view> values, const EncodingLimits& limits)
+{
+    reserve(values, limits);
+    for (std::string_view value : values)
+        pushBack(value, limits);
+}
+
+std::string ListObject::popFront()
+{
+    if (list_)
+        return list_->popFront();
+    std::string value(pack_.front());
+    pack_.popFront();
+    return value;
+}
+
+std::string ListObject::popBack()
+{
+    if (list_)
+        return list_->popBack();
+    std::string value(pack_.back());
+    pack_.popBack();
+    return value;
+}
+
+bool ListObject::packFits(std::string_view value, const EncodingLimits& limits) const
+{
+    return pack_.bytes() + ListPack::entrySize(value.size()) <= limits.listMaxListpackBytes;
+}
+
+void ListObject::reserve(std::span<const std::string_view> values, const EncodingLimits& limits)
+{
+    if (list_)
+        return;
+    size_t bytes = pack_.bytes();
+    for (std::string_view value : values)
+        bytes += ListPack::entrySize(value.size());
+    if (bytes > limits.listMaxListpackBytes)
+        convert();
+    else
+        pack_.reserve(bytes);
+}
+
+void ListObject::convert()
+{
+    auto list = std::make_unique<QuickList>();
+    for (auto pos = pack_.begin(); pos != pack_.end(); pos = pack_.next(pos))
+        list->pushBack(pack_.at(pos));
+    list_ = std::move(list);
+    pack_ = ListPack();
+}
+
+} // namespace storage
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "EncodingLimits.h"
+#include "ListPack.h"
+#include "QuickList.h"
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace storage {
+
+// A list value. A small list is a single ListPack; once that would pass the
+// EncodingLimits, the list moves into a QuickList for good.
+class ListObject {
+public:
+    ListObject() = default;
+    ListObject(const ListObject& other);
+    ListObject(ListObject&&) noexcept = default;
+    ListObject& operator=(ListObject other) noexcept;
+
+    size_t size() const { return list_ ? list_->size() : pack_.size(); }
+    bool empty() const { return size() == 0; }
+    // "listpack" or "quicklist"
+    const char* encoding() const { return list_ ? "quicklist" : "listpack"; }
+
+    void pushFront(std::string_view value, const EncodingLimits& limits);
+    void pushBack(std::string_view value, const EncodingLimits& limits);
+    // Pushes each value in turn, so the last pushed to the front ends up
+    // first. Converts at most once, and grows the ListPack at most once.
+    void pushFront(std::span<const std::string_view> values, const EncodingLimits& limits);
+    void pushBack(std::span<const std::string_view> values, const EncodingLimits& limits);
+    // Must not be empty
+    std::string popFront();
+    std::string popBack();
+
+    // Calls fn(value) for indexes start to stop inclusive; stop must be
+    // below size()
+    template <typename Fn>
+    void forEachInRange(size_t start, size_t stop, Fn fn) const
+    {
+        if (list_) {
+            list_->forEachInRange(start, stop, fn);
+            return;
+        }
+        auto pos = pack_.begin();
+        for (size_t i = 0; i < start; ++i)
+            pos = pack_.next(pos);
+        for (size_t i = start; i <= stop; ++i, pos = pack_.next(pos))
+            fn(pack_.at(pos));
+    }
+
+private:
+    // Whether pack_ can take value and stay within the limit
+    bool packFits(std::string_view value, const EncodingLimits& limits) const;
+    // Makes room for values in the encoding they'll end up in
+    void reserve(std::span<const std::string_view> values, const EncodingLimits& limits);
+    void convert();
+
+    ListPack pack_;
+    std::unique_ptr<QuickList> list_; // Set once converted; pack_ is empty then
+};
+
+} // namespace storage
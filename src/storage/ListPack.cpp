@@ -0,0 +1,119 @@
+#include "ListPack.h"
+
+namespace storage {
+
+namespace {
+    size_t varintSize(size_t value)
+    {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            ++size;
+        }
+        return size;
+    }
+
+    // Seven bits per byte, lowest first; a set top bit means more follow
+    char* writeVarint(char* out, size_t value)
+    {
+        while (value >= 0x80) {
+            *out++ = static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<char>(value);
+        return out;
+    }
+
+    size_t readVarint(const char* in, size_t& size)
+    {
+        size_t value = 0;
+        size = 0;
+        for (int shift = 0;; shift += 7) {
+            unsigned char byte = static_cast<unsigned char>(in[size++]);
+            value |= static_cast<size_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+    }
+
+    // The same varint with its bytes in reverse order, so it reads from its
+    // last byte towards its first
+    char* writeBackVarint(char* out, size_t value)
+    {
+        size_t size = varintSize(value);
+        for (size_t i = size; i-- > 0;) {
+            out[i] = static_cast<char>((value & 0x7f) | (i != 0 ? 0x80 : 0));
+            value >>= 7;
+        }
+        return out + size;
+    }
+
+    // end points one past the varint's last byte
+    size_t readBackVarint(const char* end, size_t& size)
+    {
+        size_t value = 0;
+        size = 0;
+        for (int shift = 0;; shift += 7) {
+            unsigned char byte = static_cast<unsigned char>(*(end - 1 - size++));
+            value |= static_cast<size_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+    }
+} // namespace
+
+size_t ListPack::entrySize(size_t length)
+{
+    size_t body = varintSize(length) + length;
+    return body + varintSize(body);
+}
+
+ListPack::Position ListPack::next(Position pos) const
+{
+    size_t headerSize;
+    size_t length = readVarint(data_.data() + pos, headerSize);
+    size_t body = headerSize + length;
+    return pos + body + varintSize(body);
+}
+
+ListPack::Position ListPack::prev(Position pos) const
+{
+    size_t trailerSize;
+    size_t body = readBackVarint(data_.data() + pos, trailerSize);
+    return pos - trailerSize - body;
+}
+
+std::string_view ListPack::at(Position pos) const
+{
+    size_t headerSize;
+    size_t length = readVarint(data_.data() + pos, headerSize);
+    return { data_.data() + pos + headerSize, length };
+}
+
+ListPack::Position ListPack::insert(Position pos, std::string_view value)
+{
+    size_t body = varintSize(value.size()) + value.size();
+    data_.insert(pos, entrySize(value.size()), '\0');
+    char* out = writeVarint(data_.data() + pos, value.size());
+    out += value.copy(out, value.size());
+    writeBackVarint(out, body);
+    ++count_;
+    return pos;
+}
+
+ListPack::Position ListPack::erase(Position pos)
+{
+    data_.erase(pos, next(pos) - pos);
+    --count_;
+    return pos;
+}
+
+void ListPack::replace(Position pos, std::string_view value)
+{
+    // Copy first: value may point into this entry
+    std::string copy(value);
+    erase(pos);
+    insert(pos, copy);
+}
+
+} // namespace storage
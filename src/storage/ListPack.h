@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace storage {
+
+// Strings packed back to back in one buffer, after Redis's listpack. Each
+// entry is its length as a varint, then its bytes, then the size of those
+// two again, encoded to be read backwards from the end of the entry. A walk
+// can go either way without any index, and the entries cost a few bytes
+// each instead of an allocation. Inserting or erasing moves every byte
+// behind the entry, so a ListPack is meant to stay small.
+class ListPack {
+public:
+    // Byte offset of an entry; end() is one past the last
+    using Position = size_t;
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    size_t bytes() const { return data_.size(); }
+    void reserve(size_t bytes) { data_.reserve(bytes); }
+
+    Position begin() const { return 0; }
+    Position end() const { return data_.size(); }
+    Position next(Position pos) const;
+    // pos must not be begin()
+    Position prev(Position pos) const;
+    std::string_view at(Position pos) const;
+
+    // Inserts value before pos and returns the new entry's position. value
+    // must not point into this ListPack; replace() may take one that does.
+    Position insert(Position pos, std::string_view value);
+    // Returns the position of the entry that followed
+    Position erase(Position pos);
+    void replace(Position pos, std::string_view value);
+
+    void pushFront(std::string_view value) { insert(begin(), value); }
+    void pushBack(std::string_view value) { insert(end(), value); }
+    // Must not be empty
+    std::string_view front() const { return at(begin()); }
+    std::string_view back() const { return at(prev(end())); }
+    void popFront() { erase(begin()); }
+    void popBack() { erase(prev(end())); }
+
+    // Bytes an entry of length bytes takes up, all encoding included
+    static size_t entrySize(size_t length);
+
+private:
+    std::string data_;
+    size_t count_ = 0;
+};
+
+} // namespace storage
@@ -0,0 +1,49 @@
+#include "QuickList.h"
+
+namespace storage {
+
+bool QuickList::fits(const ListPack& node, size_t length)
+{
+    // An entry bigger than a node gets one to itself
+    return node.empty() || node.bytes() + ListPack::entrySize(length) <= NODE_BYTES;
+}
+
+void QuickList::pushFront(std::string_view value)
+{
+    if (nodes_.empty() || !fits(nodes_.front(), value.size()))
+        nodes_.emplace_front();
+    nodes_.front().pushFront(value);
+    ++size_;
+}
+
+void QuickList::pushBack(std::string_view value)
+{
+    if (nodes_.empty() || !fits(nodes_.back(), value.size()))
+        nodes_.emplace_back();
+    nodes_.back().pushBack(value);
+    ++size_;
+}
+
+std::string QuickList::popFront()
+{
+    ListPack& node = nodes_.front();
+    std::string value(node.front());
+    node.popFront();
+    if (node.empty())
+        nodes_.pop_front();
+    --size_;
+    return value;
+}
+
+std::string QuickList::popBack()
+{
+    ListPack& node = nodes_.back();
+    std::string value(node.back());
+    node.popBack();
+    if (node.empty())
+        nodes_.pop_back();
+    --size_;
+    return value;
+}
+
+} // namespace storage
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ListPack.h"
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+
+namespace storage {
+
+// A list kept as a deque of ListPack nodes, after Redis's quicklist. A push
+// or pop at either end only touches the end node, which holds at most
+// NODE_BYTES, so it costs O(1). A range skips whole nodes to its start, then
+// walks the entries it returns.
+class QuickList {
+public:
+    static constexpr size_t NODE_BYTES = 8192;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // Nodes in use; a list that fits in one counts as small
+    size_t nodeCount() const { return nodes_.size(); }
+
+    void pushFront(std::string_view value);
+    void pushBack(std::string_view value);
+    // Must not be empty
+    std::string popFront();
+    std::string popBack();
+
+    // Calls fn(value) for indexes start to stop inclusive; stop must be
+    // below size()
+    template <typename Fn>
+    void forEachInRange(size_t start, size_t stop, Fn fn) const
+    {
+        auto node = nodes_.begin();
+        while (start >= node->size()) {
+            start -= node->size();
+            stop -= node->size();
+            ++node;
+        }
+        for (size_t index = 0;; ++node) {
+            for (auto pos = node->begin(); pos != node->end(); pos = node->next(pos), ++index) {
+                if (index < start)
+                    continue;
+                if (index > stop)
+                    return;
+                fn(node->at(pos));
+            }
+            if (index > stop)
+                return;
+        }
+    }
+
+private:
+    // Whether node can take an entry of length bytes, or should be left
+    // for a new node
+    static bool fits(const ListPack& node, size_t length);
+
+    std::deque<ListPack> nodes_;
+    size_t size_ = 0;
+};
+
+} // namespace storage
@@ -0,0 +1,199 @@
+#include "RedisObject.h"
+#include "IntegerString.h"
+
+#include <cstring>
+#include <utility>
+
+namespace storage {
+
+RedisObject::RedisObject(const RedisObject& other)
+{
+    switch (other.kind()) {
+    case Kind::Raw:
+        setString(other.string());
+        break;
+    case Kind::List:
+        setPointer(Kind::List, new ListObject(*other.get_if<ListObject>()));
+        break;
+    case Kind::Set:
+        setPointer(Kind::Set, new SetObject(*other.get_if<SetObject>()));
+        break;
+    case Kind::Hash:
+        setPointer(Kind::Hash, new HashObject(*other.get_if<HashObject>()));
+        break;
+    case Kind::SortedSet:
+        setPointer(Kind::SortedSet, new ZSet(*other.get_if<ZSet>()));
+        break;
+    default:
+        // Everything else lives in the 16 bytes
+        std::memcpy(data_, other.data_, INLINE_BYTES);
+        tag_ = other.tag_;
+        break;
+    }
+}
+
+RedisObject::RedisObject(RedisObject&& other) noexcept
+{
+    std::memcpy(data_, other.data_, INLINE_BYTES);
+    tag_ = std::exchange(other.tag_, static_cast<uint8_t>(Kind::Empty));
+}
+
+RedisObject& RedisObject::operator=(RedisObject other) noexcept
+{
+    std::swap(data_, other.data_);
+    std::swap(tag_, other.tag_);
+    return *this;
+}
+
+RedisObject::Type RedisObject::type() const
+{
+    switch (kind()) {
+    case Kind::Empty:
+        return Type::None;
+    case Kind::Int:
+    case Kind::Embedded:
+    case Kind::Raw:
+        return Type::String;
+    case Kind::List:
+        return Type::List;
+    case Kind::Set:
+        return Type::Set;
+    case Kind::Hash:
+        return Type::Hash;
+    default:
+        return Type::ZSet;
+    }
+}
+
+const char* RedisObject::encoding() const
+{
+    switch (kind()) {
+    case Kind::Int:
+        return "int";
+    case Kind::Embedded:
+        return "embstr";
+    case Kind::Raw:
+        return "raw";
+    case Kind::List:
+        return get_if<ListObject>()->encoding();
+    case Kind::Set:
+        return get_if<SetObject>()->encoding();
+    case Kind::Hash:
+        return get_if<HashObject>()->encoding();
+    case Kind::SortedSet:
+        return "skiplist";
+    default:
+        return "none";
+    }
+}
+
+void RedisObject::setString(std::string_view value)
+{
+    if (auto integer = parseCanonicalInteger(value)) {
+        setInteger(*integer);
+    } else if (value.size() <= INLINE_BYTES) {
+        // Copy first: value may point into this object
+        char copy[INLINE_BYTES];
+        value.copy(copy, value.size());
+        reset();
+        std::memcpy(data_, copy, value.size());
+        tag_ = static_cast<uint8_t>(static_cast<uint8_t>(Kind::Embedded) | value.size() << 4);
+    } else {
+        char* bytes = new char[value.size()];
+        value.copy(bytes, value.size());
+        reset();
+        setPointer(Kind::Raw, bytes);
+        uint64_t size = value.size();
+        std::memcpy(data_ + sizeof(void*), &size, INLINE_BYTES - sizeof(void*));
+    }
+}
+
+std::string RedisObject::string() const
+{
+    switch (kind()) {
+    case Kind::Int: {
+        char buffer[MAX_INTEGER_CHARS];
+        return std::string(formatInteger(*integer(), buffer));
+    }
+    case Kind::Embedded:
+        return std::string(data_, tag_ >> 4);
+    default:
+        return std::string(static_cast<const char*>(pointer()), rawSize());
+    }
+}
+
+size_t RedisObject::stringSize() const
+{
+    switch (kind()) {
+    case Kind::Int: {
+        char buffer[MAX_INTEGER_CHARS];
+        return formatInteger(*integer(), buffer).size();
+    }
+    case Kind::Embedded:
+        return tag_ >> 4;
+    default:
+        return rawSize();
+    }
+}
+
+std::optional<int64_t> RedisObject::integer() const
+{
+    if (kind() != Kind::Int)
+        return std::nullopt;
+    int64_t value;
+    std::memcpy(&value, data_, sizeof(value));
+    return value;
+}
+
+void RedisObject::setInteger(int64_t value)
+{
+    reset();
+    std::memcpy(data_, &value, sizeof(value));
+    tag_ = static_cast<uint8_t>(Kind::Int);
+}
+
+void* RedisObject::pointer() const
+{
+    void* pointer;
+    std::memcpy(&pointer, data_, sizeof(pointer));
+    return pointer;
+}
+
+void RedisObject::setPointer(Kind kind, void* pointer)
+{
+    std::memcpy(data_, &pointer, sizeof(pointer));
+    tag_ = static_cast<uint8_t>(kind);
+}
+
+size_t RedisObject::rawSize() const
+{
+    uint64_t size = 0;
+    std::memcpy(&size, data_ + sizeof(void*), INLINE_BYTES - sizeof(void*));
+    return size;
+}
+
+void RedisObject::reset()
+{
+    switch (kind()) {
+    case Kind::Raw:
+        delete[] static_cast<char*>(pointer());
+        break;
+    case Kind::List:
+        delete get_if<ListObject>();
+        break;
+    case Kind::Set:
+        delete get_if<SetObject>();
+        break;
+    case Kind::Hash:
+        delete get_if<HashObject>();
+        break;
+    case Kind::SortedSet:
+        delete get_if<ZSet>();
+        break;
+    default:
+        break;
+    }
+    tag_ = static_cast<uint8_t>(Kind::Empty);
+}
+
+} // namespace storage
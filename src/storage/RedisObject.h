@@ -0,0 +1,103 @@
+#pragma once
+
+#include "HashObject.h"
+#include "ListObject.h"
+#include "SetObject.h"
+#include "ZSet.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace storage {
+
+// A keyspace value in 16 bytes, after Redis's robj. The last byte tags what
+// the first fifteen hold:
+//  - a string that is a canonical integer, as an int64_t ("int")
+//  - a string of up to 15 bytes, in place ("embstr")
+//  - a longer string, as a pointer and a 56-bit length to exactly its bytes
+//    on the heap ("raw")
+//  - a pointer to a list, set, hash or sorted set
+// Most values in a cache are small, so most keys cost their slot and no
+// allocation at all.
+class RedisObject {
+public:
+    enum class Type : uint8_t { None, String, List, Set, Hash, ZSet };
+
+    RedisObject() = default;
+    explicit RedisObject(std::string_view string) { setString(string); }
+    RedisObject(const RedisObject& other);
+    RedisObject(RedisObject&& other) noexcept;
+    RedisObject& operator=(RedisObject other) noexcept;
+    ~RedisObject() { reset(); }
+
+    Type type() const;
+    // "int", "embstr" or "raw" for a string, the collection's own otherwise
+    const char* encoding() const;
+
+    // Replaces the value with a string, in the smallest encoding that holds
+    // it
+    void setString(std::string_view value);
+    // Must hold a string
+    std::string string() const;
+    size_t stringSize() const;
+    // The value of a string held as an int64_t. Any canonical integer is
+    // held that way, so a counter is read and written without parsing.
+    std::optional<int64_t> integer() const;
+    void setInteger(int64_t value);
+
+    // The collection held, or nullptr if it holds something else
+    template <typename T>
+    T* get_if()
+    {
+        return kind() == kindOf<T>() ? static_cast<T*>(pointer()) : nullptr;
+    }
+    template <typename T>
+    const T* get_if() const
+    {
+        return kind() == kindOf<T>() ? static_cast<const T*>(pointer()) : nullptr;
+    }
+    // Replaces the value with an empty collection and returns it
+    template <typename T>
+    T& emplace()
+    {
+        T* collection = new T();
+        reset();
+        setPointer(kindOf<T>(), collection);
+        return *collection;
+    }
+
+private:
+    enum class Kind : uint8_t { Empty, Int, Embedded, Raw, List, Set, Hash, SortedSet };
+    static constexpr size_t INLINE_BYTES = 15;
+
+    template <typename T>
+    static constexpr Kind kindOf()
+    {
+        if constexpr (std::is_same_v<T, ListObject>)
+            return Kind::List;
+        else if constexpr (std::is_same_v<T, SetObject>)
+            return Kind::Set;
+        else if constexpr (std::is_same_v<T, HashObject>)
+            return Kind::Hash;
+        else
+            return Kind::SortedSet;
+    }
+
+    // The tag keeps the kind in its low nibble and an embedded string's
+    // length in its high one
+    Kind kind() const { return static_cast<Kind>(tag_ & 0x0f); }
+    void* pointer() const;
+    void setPointer(Kind kind, void* pointer);
+    size_t rawSize() const;
+    void reset();
+
+    alignas(8) char data_[INLINE_BYTES] = {};
+    uint8_t tag_ = 0; // Kind::Empty
+};
+
+static_assert(sizeof(RedisObject) == 16);
+
+} // namespace storage
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <utility>
+#include <variant>
+
+namespace storage {
+
+enum class StoreError {
+    NoKey, // The key, or the element asked for, doesn't exist
+    WrongType, // The key holds a different kind of value
+    NotNumber, // The value isn't the kind of number the operation takes
+    OutOfRange // The result wouldn't fit, or wouldn't be a finite number
+};
+
+// A value, or the reason there isn't one. A small stand-in for
+// std::expected<T, StoreError>, which only arrives with C++23.
+template <typename T>
+class Result {
+public:
+    Result(T value)
+        : data_(std::move(value))
+    {
+    }
+    Result(StoreError error)
+        : data_(error)
+    {
+    }
+
+    bool has_value() const { return data_.index() == 0; }
+    explicit operator bool() const { return has_value(); }
+
+    T& operator*() { return std::get<0>(data_); }
+    const T& operator*() const { return std::get<0>(data_); }
+    T* operator->() { return &std::get<0>(data_); }
+    const T* operator->() const { return &std::get<0>(data_); }
+
+    StoreError error() const { return std::get<1>(data_); }
+
+private:
+    std::variant<T, StoreError> data_;
+};
+
+} // namespace storage
@@ -0,0 +1,227 @@
+#include "SetObject.h"
+
+#include <algorithm>
+
+namespace storage {
+
+SetObject::SetObject(const SetObject& other)
+{
+    if (auto* table = std::get_if<std::unique_ptr<Table>>(&other.rep_))
+        rep_ = std::make_unique<Table>(**table);
+    else if (auto* pack = std::get_if<ListPack>(&other.rep_))
+        rep_ = *pack;
+    else
+        rep_ = std::get<IntSet>(other.rep_);
+}
+
+SetObject& SetObject::operator=(SetObject other) noexcept
+{
+    std::swap(rep_, other.rep_);
+    return *this;
+}
+
+size_t SetObject::size() const
+{
+    if (auto* ints = std::get_if<IntSet>(&rep_))
+        return ints->size();
+    if (auto* pack = std::get_if<ListPack>(&rep_))
+        return pack->size();
+    return std::get<std::unique_ptr<Table>>(rep_)->size();
+}
+
+const char* SetObject::encoding() const
+{
+    switch (rep_.index()) {
+    case 0:
+        return "intset";
+    case 1:
+        return "listpack";
+    default:
+        return "hashtable";
+    }
+}
+
+bool SetObject::add(std::string_view member, const EncodingLimits& limits)
+{
+    if (auto* ints = std::get_if<IntSet>(&rep_)) {
+        auto value = parseCanonicalInteger(member);
+        if (value && ints->contains(*value))
+            return false;
+        if (value && ints->size() < limits.setMaxIntsetEntries)
+            return ints->insert(*value);
+        if (!value && ints->size() < limits.setMaxListpackEntries && member.size() <= limits.setMaxListpackValue)
+            convertToListPack();
+        else
+            convertToTable();
+    }
+    if (auto* pack = std::get_if<ListPack>(&rep_)) {
+        if (find(*pack, member) != pack->end())
+            return false;
+        if (pack->size() < limits.setMaxListpackEntries && member.size() <= limits.setMaxListpackValue) {
+            pack->pushBack(member);
+            return true;
+        }
+        convertToTable();
+    }
+    auto& table = *std::get<std::unique_ptr<Table>>(rep_);
+    if (table.contains(member))
+        return false;
+    table.emplace(member);
+    return true;
+}
+
+bool SetObject::remove(std::string_view member)
+{
+    if (auto* ints = std::get_if<IntSet>(&rep_)) {
+        auto value = parseCanonicalInteger(member);
+        return value && ints->erase(*value);
+    }
+    if (auto* pack = std::get_if<ListPack>(&rep_)) {
+        auto pos = find(*pack, member);
+        if (pos == pack->end())
+            return false;
+        pack->erase(pos);
+        return true;
+    }
+    auto& table = *std::get<std::unique_ptr<Table>>(rep_);
+    auto it = table.find(member);
+    if (it == table.end())
+        return false;
+    table.erase(it);
+    return true;
+}
+
+bool SetObject::contains(std::string_view member) const
+{
+    if (auto* ints = std::get_if<IntSet>(&rep_)) {
+        auto value = parseCanonicalInteger(member);
+        return value && ints->contains(*value);
+    }
+    if (auto* pack = std::get_if<ListPack>(&rep_))
+        return find(*pack, member) != pack->end();
+    return std::get<std::unique_ptr<Table>>(rep_)->contains(member);
+}
+
+void SetObject::reserve(size_t count, const EncodingLimits& limits)
+{
+    if (std::holds_alternative<IntSet>(rep_) && count > limits.setMaxIntsetEntries)
+        convertToTable();
+    else if (std::holds_alternative<ListPack>(rep_) && count > limits.setMaxListpackEntries)
+        convertToTable();
+    if (auto* table = std::get_if<std::unique_ptr<Table>>(&rep_))
+        (*table)->reserve(count);
+}
+
+SetObject SetObject::intersectionOf(std::span<const SetObject* const> sets, const EncodingLimits& limits, size_t limit)
+{
+    SetObject result;
+    if (sets.empty() || std::find(sets.begin(), sets.end(), nullptr) != sets.end())
+        return result;
+    // Every member comes from the smallest set, and is checked against the
+    // next smallest first, as the likeliest to rule it out
+    std::vector<const SetObject*> bySize(sets.begin(), sets.end());
+    std::sort(bySize.begin(), bySize.end(), [](const SetObject* a, const SetObject* b) { return a->size() < b->size(); });
+
+    std::vector<const IntSet*> ints;
+    for (const SetObject* set : bySize) {
+        if (auto* intSet = std::get_if<IntSet>(&set->rep_))
+            ints.push_back(intSet);
+    }
+    if (ints.size() == bySize.size()) {
+        result.rep_ = intersectIntSets(ints, limit);
+        return result;
+    }
+
+    bySize.front()->forEach([&](std::string_view member) {
+        if (result.size() >= limit)
+            return;
+        for (size_t i = 1; i < bySize.size(); ++i) {
+            if (!bySize[i]->contains(member))
+                return;
+        }
+        result.add(member, limits);
+    });
+    return result;
+}
+
+IntSet SetObject::intersectIntSets(std::span<const IntSet* const> sets, size_t limit)
+{
+    // A cursor per set that only moves forward, each step a binary search
+    // from it, so walking a small set against a large one costs about
+    // log(large) per member. Matches are found in order and append.
+    IntSet result;
+    std::vector<size_t> cursors(sets.size());
+    const IntSet& smallest = *sets.front();
+    for (size_t i = 0; i < smallest.size() && result.size() < limit; ++i) {
+        int64_t value = smallest.at(i);
+        bool inAll = true;
+        for (size_t s = 1; s < sets.size() && inAll; ++s) {
+            cursors[s] = sets[s]->lowerBound(value, cursors[s]);
+            if (cursors[s] == sets[s]->size())
+                return result;
+            inAll = sets[s]->at(cursors[s]) == value;
+        }
+        if (inAll)
+            result.insert(value);
+    }
+    return result;
+}
+
+SetObject SetObject::unionOf(std::span<const SetObject* const> sets, const EncodingLimits& limits)
+{
+    // Copying the largest set whole beats adding its members one by one
+    const SetObject* largest = nullptr;
+    for (const SetObject* set : sets) {
+        if (set && (!largest || set->size() > largest->size()))
+            largest = set;
+    }
+    if (!largest)
+        return SetObject();
+    SetObject result(*largest);
+    for (const SetObject* set : sets) {
+        if (set && set != largest)
+            set->forEach([&](std::string_view member) { result.add(member, limits); });
+    }
+    return result;
+}
+
+SetObject SetObject::differenceOf(std::span<const SetObject* const> sets, const EncodingLimits& limits)
+{
+    SetObject result;
+    if (sets.empty() || !sets.front())
+        return result;
+    sets.front()->forEach([&](std::string_view member) {
+        for (size_t i = 1; i < sets.size(); ++i) {
+            if (sets[i] && sets[i]->contains(member))
+                return;
+        }
+        result.add(member, limits);
+    });
+    return result;
+}
+
+ListPack::Position SetObject::find(const ListPack& pack, std::string_view member)
+{
+    for (auto pos = pack.begin(); pos != pack.end(); pos = pack.next(pos)) {
+        if (pack.at(pos) == member)
+            return pos;
+    }
+    return pack.end();
+}
+
+void SetObject::convertToListPack()
+{
+    ListPack pack;
+    forEach([&](std::string_view member) { pack.pushBack(member); });
+    rep_ = std::move(pack);
+}
+
+void SetObject::convertToTable()
+{
+    auto table = std::make_unique<Table>();
+    table->reserve(size() + 1);
+    forEach([&](std::string_view member) { table->emplace(member); });
+    rep_ = std::move(table);
+}
+
+} // namespace storage
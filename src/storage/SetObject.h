@@ -0,0 +1,82 @@
+#pragma once
+
+#include "EncodingLimits.h"
+#include "IntSet.h"
+#include "IntegerString.h"
+#include "ListPack.h"
+#include "StringHash.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+namespace storage {
+
+// A set value. A set of integers is an IntSet; other small sets are a
+// ListPack of members, searched linearly. Past the EncodingLimits, or when an
+// IntSet is given a member that isn't an integer, a set moves on to a
+// ListPack or a hash set, and never back.
+class SetObject {
+public:
+    using Table = std::unordered_set<std::string, StringHash, std::equal_to<>>;
+
+    SetObject() = default;
+    SetObject(const SetObject& other);
+    SetObject(SetObject&&) noexcept = default;
+    SetObject& operator=(SetObject other) noexcept;
+
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    // "intset", "listpack" or "hashtable"
+    const char* encoding() const;
+
+    // Returns true if member is new
+    bool add(std::string_view member, const EncodingLimits& limits);
+    bool remove(std::string_view member);
+    bool contains(std::string_view member) const;
+    // Makes room for count members in all, converting to a hash set now if
+    // that many would pass the limits of the current encoding
+    void reserve(size_t count, const EncodingLimits& limits);
+
+    // The views passed to fn are good only for that call
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        if (auto* ints = std::get_if<IntSet>(&rep_)) {
+            char buffer[MAX_INTEGER_CHARS];
+            ints->forEach([&](int64_t value) { fn(formatInteger(value, buffer)); });
+        } else if (auto* pack = std::get_if<ListPack>(&rep_)) {
+            for (auto pos = pack->begin(); pos != pack->end(); pos = pack->next(pos))
+                fn(pack->at(pos));
+        } else {
+            for (const auto& member : *std::get<std::unique_ptr<Table>>(rep_))
+                fn(std::string_view(member));
+        }
+    }
+
+    // Set algebra, encoding the result for limits as add() would. A null
+    // set stands for a missing key and counts as empty. The intersection
+    // walks the smallest set, stops after limit members, and merges sorted
+    // arrays when every set is an IntSet.
+    static SetObject intersectionOf(std::span<const SetObject* const> sets, const EncodingLimits& limits,
+        size_t limit = SIZE_MAX);
+    static SetObject unionOf(std::span<const SetObject* const> sets, const EncodingLimits& limits);
+    // Members of the first set in none of the others
+    static SetObject differenceOf(std::span<const SetObject* const> sets, const EncodingLimits& limits);
+
+private:
+    // sets must be ordered smallest first
+    static IntSet intersectIntSets(std::span<const IntSet* const> sets, size_t limit);
+    static ListPack::Position find(const ListPack& pack, std::string_view member);
+    void convertToListPack();
+    void convertToTable();
+
+    // Starts as an IntSet and only moves rightwards
+    std::variant<IntSet, ListPack, std::unique_ptr<Table>> rep_;
+};
+
+} // namespace storage
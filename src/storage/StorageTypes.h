@@ -1,26 +1,20 @@
 #pragma once
 
-#include <map>
-#include <string>
-#include <unordered_map>
-#include <unordered_set>
-#include <variant>
-#include <vector>
+#include "Dict.h"
+#include "RedisObject.h"
+#include "StringHash.h"
 
 namespace storage {
 
-using RedisString = std::string;
-using RedisList = std::vector<std::string>;
-using RedisSet = std::unordered_set<std::string>;
-using RedisHash = std::unordered_map<std::string, std::string>;
-using RedisZSet = std::map<double, std::string>;
+using RedisList = ListObject;
+using RedisSet = SetObject;
+using RedisHash = HashObject;
+using RedisZSet = ZSet;
 
-using RedisVariant = std::variant<
-    std::monostate,
-    RedisString,
-    RedisList,
-    RedisSet,
-    RedisHash,
-    RedisZSet>;
+// Flat rather than node-based: no allocation per key, and a lookup reads the
+// entry straight out of the table. Grows incrementally, so a resize never
+// stalls a command. A slot is the key's std::string and a 16-byte
+// RedisObject.
+using Keyspace = Dict<std::string, RedisObject, StringHash, std::equal_to<>>;
 
 } // namespace storage
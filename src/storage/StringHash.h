@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+
+namespace storage {
+
+// Hashes std::string and std::string_view alike, so maps keyed by
+// std::string can be searched with a view and no temporary string
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view text) const { return std::hash<std::string_view> {}(text); }
+};
+
+} // namespace storage
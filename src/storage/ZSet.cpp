@@ -0,0 +1,272 @@
+#include "ZSet.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace storage {
+
+namespace {
+    // Cheap and good enough to pick node heights; one per reactor thread
+    uint64_t nextRandom()
+    {
+        thread_local uint64_t state = 0x9e3779b97f4a7c15ULL;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+} // namespace
+
+ZSet::ZSet()
+    : head_(createNode(MAX_LEVEL, {}, 0))
+{
+    for (int i = 0; i < MAX_LEVEL; ++i)
+        head_->levels()[i] = { nullptr, 0 };
+}
+
+ZSet::ZSet(const ZSet& other)
+    : ZSet()
+{
+    members_.reserve(other.size());
+    for (const Node* node = other.head_->levels()[0].forward; node; node = node->levels()[0].forward)
+        insert(node->member, node->score);
+}
+
+ZSet::ZSet(ZSet&& other) noexcept
+    : ZSet()
+{
+    swap(other);
+}
+
+ZSet& ZSet::operator=(ZSet other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+ZSet::~ZSet()
+{
+    Node* node = head_;
+    while (node) {
+        Node* next = node->levels()[0].forward;
+        destroyNode(node);
+        node = next;
+    }
+}
+
+void ZSet::swap(ZSet& other) noexcept
+{
+    std::swap(head_, other.head_);
+    std::swap(tail_, other.tail_);
+    std::swap(length_, other.length_);
+    std::swap(level_, other.level_);
+    members_.swap(other.members_);
+}
+
+bool ZSet::insert(std::string_view member, double score)
+{
+    auto found = members_.find(member);
+    if (found != members_.end()) {
+        Node* node = found->second;
+        if (node->score != score) {
+            unlink(node);
+            node->score = score;
+            link(node);
+        }
+        return false;
+    }
+    Node* node = createNode(randomHeight(), member, score);
+    link(node);
+    members_.try_emplace(std::string_view(node->member), node);
+    return true;
+}
+
+bool ZSet::erase(std::string_view member)
+{
+    auto found = members_.find(member);
+    if (found == members_.end())
+        return false;
+    Node* node = found->second;
+    members_.erase(found);
+    unlink(node);
+    destroyNode(node);
+    return true;
+}
+
+std::optional<double> ZSet::score(std::string_view member) const
+{
+    auto found = members_.find(member);
+    if (found == members_.end())
+        return std::nullopt;
+    return found->second->score;
+}
+
+std::optional<size_t> ZSet::rank(std::string_view member) const
+{
+    auto found = members_.find(member);
+    if (found == members_.end())
+        return std::nullopt;
+    const Node* target = found->second;
+
+    // Walk towards target, adding up the spans of the links taken
+    size_t traversed = 0;
+    const Node* node = head_;
+    for (int i = level_ - 1; i >= 0; --i) {
+        while (node->levels()[i].forward && node->levels()[i].forward != target
+            && !before(target->score, target->member, node->levels()[i].forward)) {
+            traversed += node->levels()[i].span;
+            node = node->levels()[i].forward;
+        }
+        if (node->levels()[i].forward == target)
+            return traversed + node->levels()[i].span - 1;
+    }
+    return std::nullopt;
+}
+
+std::pair<size_t, size_t> ZSet::rankRange(const ScoreRange& range) const
+{
+    size_t first = countBelow(range.min, range.minExclusive);
+    size_t last = countBelow(range.max, !range.maxExclusive);
+    return { first, std::max(first, last) };
+}
+
+std::optional<double> ZSet::incrementBy(std::string_view member, double delta)
+{
+    double updated = score(member).value_or(0) + delta;
+    if (std::isnan(updated))
+        return std::nullopt;
+    insert(member, updated);
+    return updated;
+}
+
+ZSet::Node* ZSet::createNode(int height, std::string_view member, double score)
+{
+    void* memory = ::operator new(sizeof(Node) + height * sizeof(Level));
+    return new (memory) Node { std::string(member), score, nullptr, height };
+}
+
+void ZSet::destroyNode(Node* node)
+{
+    node->~Node();
+    ::operator delete(node);
+}
+
+// Each level up holds a quarter of the nodes of the one below
+int ZSet::randomHeight()
+{
+    int height = 1;
+    for (uint64_t bits = nextRandom(); height < MAX_LEVEL && (bits & 3) == 0; bits >>= 2)
+        ++height;
+    return height;
+}
+
+bool ZSet::before(double score, std::string_view member, const Node* node)
+{
+    return score < node->score || (score == node->score && member < node->member);
+}
+
+void ZSet::link(Node* node)
+{
+    Node* update[MAX_LEVEL]; // Last node before node on each level
+    size_t rank[MAX_LEVEL]; // Rank of update[i], counting head_ as 0
+
+    Node* x = head_;
+    for (int i = level_ - 1; i >= 0; --i) {
+        rank[i] = i == level_ - 1 ? 0 : rank[i + 1];
+        while (x->levels()[i].forward && !before(node->score, node->member, x->levels()[i].forward)) {
+            rank[i] += x->levels()[i].span;
+            x = x->levels()[i].forward;
+        }
+        update[i] = x;
+    }
+    if (node->height > level_) {
+        for (int i = level_; i < node->height; ++i) {
+            rank[i] = 0;
+            update[i] = head_;
+            head_->levels()[i].span = length_;
+        }
+        level_ = node->height;
+    }
+
+    for (int i = 0; i < node->height; ++i) {
+        Level& prev = update[i]->levels()[i];
+        node->levels()[i].forward = prev.forward;
+        node->levels()[i].span = prev.span - (rank[0] - rank[i]);
+        prev.forward = node;
+        prev.span = rank[0] - rank[i] + 1;
+    }
+    // Links above node now skip one more entry
+    for (int i = node->height; i < level_; ++i)
+        ++update[i]->levels()[i].span;
+
+    node->backward = update[0] == head_ ? nullptr : update[0];
+    if (Node* next = node->levels()[0].forward)
+        next->backward = node;
+    else
+        tail_ = node;
+    ++length_;
+}
+
+void ZSet::unlink(Node* node)
+{
+    Node* update[MAX_LEVEL];
+    Node* x = head_;
+    for (int i = level_ - 1; i >= 0; --i) {
+        while (x->levels()[i].forward && x->levels()[i].forward != node
+            && before(x->levels()[i].forward->score, x->levels()[i].forward->member, node)) {
+            x = x->levels()[i].forward;
+        }
+        update[i] = x;
+    }
+
+    for (int i = 0; i < level_; ++i) {
+        Level& prev = update[i]->levels()[i];
+        if (prev.forward == node) {
+            prev.span += node->levels()[i].span - 1;
+            prev.forward = node->levels()[i].forward;
+        } else {
+            --prev.span;
+        }
+    }
+    if (Node* next = node->levels()[0].forward)
+        next->backward = node->backward;
+    else
+        tail_ = node->backward;
+    while (level_ > 1 && !head_->levels()[level_ - 1].forward)
+        --level_;
+    --length_;
+}
+
+const ZSet::Node* ZSet::nodeAtRank(size_t rank) const
+{
+    // Ranks here count from 1, head_ being 0
+    size_t target = rank + 1;
+    size_t traversed = 0;
+    const Node* node = head_;
+    for (int i = level_ - 1; i >= 0; --i) {
+        while (node->levels()[i].forward && traversed + node->levels()[i].span <= target) {
+            traversed += node->levels()[i].span;
+            node = node->levels()[i].forward;
+        }
+        if (traversed == target)
+            return node;
+    }
+    return nullptr;
+}
+
+size_t ZSet::countBelow(double score, bool inclusive) const
+{
+    size_t traversed = 0;
+    const Node* node = head_;
+    for (int i = level_ - 1; i >= 0; --i) {
+        for (const Node* next; (next = node->levels()[i].forward) && (next->score < score || (inclusive && next->score == score));) {
+            traversed += node->levels()[i].span;
+            node = next;
+        }
+    }
+    return traversed;
+}
+
+} // namespace storage
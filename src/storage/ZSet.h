@@ -0,0 +1,110 @@
+#pragma once
+
+#include "FlatHashMap.h"
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace storage {
+
+// Scores from min to max, each end inclusive unless marked exclusive
+struct ScoreRange {
+    double min;
+    double max;
+    bool minExclusive = false;
+    bool maxExclusive = false;
+};
+
+struct ScoredMember {
+    std::string member;
+    double score;
+};
+
+// Sorted set ordered by (score, member), after Redis's zset: a skiplist keeps
+// the order and a hash from member to skiplist node finds a member's entry
+// directly. Each skiplist link records how many entries it skips, which gives
+// a member's rank, or the entry at a rank, in O(log n).
+class ZSet {
+public:
+    ZSet();
+    ZSet(const ZSet& other);
+    ZSet(ZSet&& other) noexcept;
+    ZSet& operator=(ZSet other) noexcept;
+    ~ZSet();
+
+    void swap(ZSet& other) noexcept;
+
+    size_t size() const { return length_; }
+    bool empty() const { return length_ == 0; }
+
+    // Adds member, or moves it to score if it's already there. Returns true
+    // if member is new.
+    bool insert(std::string_view member, double score);
+    bool erase(std::string_view member);
+    // Makes room for count members in all
+    void reserve(size_t count) { members_.reserve(count); }
+
+    std::optional<double> score(std::string_view member) const;
+    // 0 for the lowest score
+    std::optional<size_t> rank(std::string_view member) const;
+    // Ranks [first, last) hold the entries with scores in range
+    std::pair<size_t, size_t> rankRange(const ScoreRange& range) const;
+
+    // Adds delta to member's score, adding member at delta if it's missing.
+    // Returns the new score, or nullopt, changing nothing, if it's NaN.
+    std::optional<double> incrementBy(std::string_view member, double delta);
+
+    // Calls fn(member, score) for ranks start to stop inclusive, which must
+    // be below size(). With reverse, ranks count down from the highest score.
+    template <typename Fn>
+    void forEachInRank(size_t start, size_t stop, bool reverse, Fn fn) const
+    {
+        const Node* node = nodeAtRank(reverse ? length_ - 1 - start : start);
+        for (size_t i = start; i <= stop && node; ++i) {
+            fn(std::string_view(node->member), node->score);
+            node = reverse ? node->backward : node->levels()[0].forward;
+        }
+    }
+
+private:
+    static constexpr int MAX_LEVEL = 32;
+
+    struct Node;
+    struct Level {
+        Node* forward;
+        size_t span; // Entries this link skips over, counting forward
+    };
+    // Allocated with its levels right behind it
+    struct Node {
+        std::string member;
+        double score;
+        Node* backward;
+        int height;
+
+        Level* levels() { return reinterpret_cast<Level*>(this + 1); }
+        const Level* levels() const { return reinterpret_cast<const Level*>(this + 1); }
+    };
+
+    static Node* createNode(int height, std::string_view member, double score);
+    static void destroyNode(Node* node);
+    static int randomHeight();
+    // Whether the entry (score, member) sorts before node
+    static bool before(double score, std::string_view member, const Node* node);
+
+    void link(Node* node);
+    void unlink(Node* node);
+    const Node* nodeAtRank(size_t rank) const;
+    // Entries scoring below score, or at most score if inclusive
+    size_t countBelow(double score, bool inclusive) const;
+
+    Node* head_; // Sentinel with MAX_LEVEL levels
+    Node* tail_ = nullptr;
+    size_t length_ = 0;
+    int level_ = 1; // Levels in use
+    // Views of each node's own member, so members are stored once
+    FlatHashMap<std::string_view, Node*> members_;
+};
+
+} // namespace storage
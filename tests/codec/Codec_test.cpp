@@ -1,6 +1,10 @@
 #include "Codec.h"
 #include "CodecValue.h"
+#include "Scanner.h"
+#include "StreamDecoder.h"
 #include <gtest/gtest.h>
+#include <limits>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -105,6 +109,16 @@ TEST(CodecTest, NullBulkString)
         << "Decoded nullBulk() does not match original value.";
 }
 
+// Null Array (RESP: *-1\r\n), distinct from both *0 and $-1
+TEST(CodecTest, NullArray)
+{
+    EXPECT_EQ(Codec::encode(nullArray()), "*-1\r\n");
+    TestRoundTrip(nullArray(), "*-1\r\n");
+    EXPECT_FALSE(nullArray() == array({}));
+    EXPECT_FALSE(nullArray() == nullBulk());
+    TestRoundTrip(array({ nullArray(), bulk("x") }), "*2\r\n*-1\r\n$1\r\nx\r\n");
+}
+
 // Array (RESP: *<size>\r\n<element1>...<elementN>)
 TEST(CodecTest, Array_Basic)
 {
@@ -182,3 +196,279 @@ TEST(CodecTest, EmptyInput_Decode)
 {
     EXPECT_THROW(Codec::decode(""), std::runtime_error);
 }
+
+// Partial input is reported as "not yet" rather than an error
+TEST(CodecTest, TryDecode_Pipelined)
+{
+    std::string data = "+OK\r\n:42\r\n$5\r\nhel";
+    size_t pos = 0;
+
+    auto first = Codec::tryDecode(data, pos);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(*first, ok());
+
+    auto second = Codec::tryDecode(data, pos);
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(*second, integer(42));
+
+    size_t partialStart = pos;
+    EXPECT_FALSE(Codec::tryDecode(data, pos).has_value());
+    EXPECT_EQ(pos, partialStart);
+
+    data += "lo\r\n";
+    auto third = Codec::tryDecode(data, pos);
+    ASSERT_TRUE(third.has_value());
+    EXPECT_EQ(*third, bulk("hello"));
+    EXPECT_EQ(pos, data.size());
+
+    // Malformed input still throws
+    EXPECT_THROW(Codec::tryDecode("*X\r\n", pos = 0), std::runtime_error);
+}
+
+// encodedSize is exact and encodeInto appends what encode returns
+TEST(CodecTest, EncodeInto_ExactSize)
+{
+    std::vector<CodecValue> values = {
+        ok(), err("ERR bad"), integer(0), integer(1023), integer(1024), integer(-1),
+        integer(std::numeric_limits<long long>::min()), integer(std::numeric_limits<long long>::max()),
+        bulk(""), bulk(std::string(1000, 'x')), nullBulk(), array({}), nullArray(),
+        array({ bulk("a"), array({ integer(7), nullBulk() }), CodecValue { SimpleString { "PONG" } } })
+    };
+
+    // Appends after what's already there, with the size known up front
+    std::string out = "prefix";
+    std::string expected = "prefix";
+    for (const CodecValue& value : values) {
+        std::string encoded = Codec::encode(value);
+        EXPECT_EQ(Codec::encodedSize(value), encoded.size()) << encoded;
+        EXPECT_EQ(Codec::decode(encoded), value);
+        Codec::encodeInto(value, out);
+        expected += encoded;
+    }
+    EXPECT_EQ(out, expected);
+    EXPECT_EQ(Codec::encode(integer(std::numeric_limits<long long>::min())), ":-9223372036854775808\r\n");
+}
+
+// Streaming decoder: a value fed one byte at a time decodes the same as a whole
+TEST(StreamDecoderTest, ByteAtATime)
+{
+    CodecValue expected = array({ bulk("SET"), bulk("key"), array({ integer(-7), nullBulk(), array({}), nullArray() }),
+        CodecValue { SimpleString { "PONG" } }, err("ERR bad") });
+    std::string data = Codec::encode(expected);
+
+    StreamDecoder decoder;
+    for (size_t i = 0; i + 1 < data.size(); ++i) {
+        decoder.feed(&data[i], 1);
+        EXPECT_FALSE(decoder.next().has_value()) << "value completed early at byte " << i;
+    }
+    decoder.feed(&data.back(), 1);
+
+    auto value = decoder.next();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, expected);
+    EXPECT_EQ(decoder.buffered(), 0u);
+}
+
+TEST(StreamDecoderTest, PipelinedValues)
+{
+    std::string data = Codec::encode(array({ bulk("GET"), bulk("a") })) + "+OK\r\n:5\r\n$3\r\nab";
+
+    StreamDecoder decoder;
+    decoder.feed(data.data(), data.size());
+    EXPECT_EQ(decoder.next(), array({ bulk("GET"), bulk("a") }));
+    EXPECT_EQ(decoder.next(), ok());
+    EXPECT_EQ(decoder.next(), integer(5));
+    EXPECT_FALSE(decoder.next().has_value());
+
+    decoder.feed("c\r\n", 3);
+    EXPECT_EQ(decoder.next(), bulk("abc"));
+    EXPECT_FALSE(decoder.next().has_value());
+}
+
+TEST(StreamDecoderTest, LargeBulkInChunks)
+{
+    std::string payload(1 << 20, 'x');
+    std::string data = Codec::encode(array({ bulk("SET"), bulk("big"), bulk(payload) }));
+
+    StreamDecoder decoder;
+    std::optional<CodecValue> value;
+    for (size_t i = 0; i < data.size(); i += 4096) {
+        ASSERT_FALSE(value.has_value());
+        decoder.feed(data.data() + i, std::min<size_t>(4096, data.size() - i));
+        value = decoder.next();
+    }
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, array({ bulk("SET"), bulk("big"), bulk(payload) }));
+}
+
+TEST(StreamDecoderTest, InvalidInput)
+{
+    for (std::string data : { "!4\r\nabcd\r\n", "$abc\r\n", "*X\r\n", "$3\r\nabcde\r\n", ":12x\r\n" }) {
+        StreamDecoder decoder;
+        decoder.feed(data.data(), data.size());
+        EXPECT_THROW(decoder.next(), std::runtime_error) << data;
+    }
+}
+
+TEST(StreamDecoderTest, CommandViews)
+{
+    std::string first = Codec::encode(array({ bulk("SET"), bulk("key"), bulk("value") }));
+    std::string second = Codec::encode(array({ bulk("GET"), bulk("key") }));
+    std::string data = first + second + "*0\r\n" + second;
+
+    // Split inside the second request: the first stays readable, the second
+    // is resumed after the next feed
+    StreamDecoder decoder;
+    size_t split = first.size() + 9;
+    decoder.feed(data.data(), split);
+
+    std::vector<std::string_view> args;
+    ASSERT_TRUE(decoder.nextCommand(args));
+    EXPECT_EQ(args, (std::vector<std::string_view> { "SET", "key", "value" }));
+    EXPECT_FALSE(decoder.nextCommand(args));
+    EXPECT_EQ(args.size(), 3u);
+
+    args.clear();
+    decoder.feed(data.data() + split, data.size() - split);
+    ASSERT_TRUE(decoder.nextCommand(args));
+    ASSERT_TRUE(decoder.nextCommand(args));
+    ASSERT_TRUE(decoder.nextCommand(args));
+    EXPECT_EQ(args, (std::vector<std::string_view> { "GET", "key", "GET", "key" }));
+    EXPECT_FALSE(decoder.nextCommand(args));
+    EXPECT_EQ(decoder.buffered(), 0u);
+}
+
+TEST(StreamDecoderTest, CommandWholeAndSplitAgree)
+{
+    std::string data = Codec::encode(array({ bulk("SET"), bulk("key"), bulk(std::string(300, 'v')) }))
+        + Codec::encode(array({ bulk(""), bulk("x") })) + "*0\r\n" + Codec::encode(array({ bulk("PING") }));
+    std::vector<std::string> expected = { "SET", "key", std::string(300, 'v'), "", "x", "PING" };
+
+    // All at once takes the fast path for complete requests
+    StreamDecoder whole;
+    whole.feed(data.data(), data.size());
+    std::vector<std::string_view> args;
+    for (int i = 0; i < 4; ++i)
+        ASSERT_TRUE(whole.nextCommand(args));
+    EXPECT_FALSE(whole.nextCommand(args));
+    EXPECT_EQ(std::vector<std::string>(args.begin(), args.end()), expected);
+
+    // A byte at a time goes through the resumable path
+    StreamDecoder split;
+    std::vector<std::string> collected;
+    for (char c : data) {
+        split.feed(&c, 1);
+        args.clear();
+        while (split.nextCommand(args)) {
+        }
+        collected.insert(collected.end(), args.begin(), args.end());
+    }
+    EXPECT_EQ(collected, expected);
+}
+
+TEST(StreamDecoderTest, CommandInvalidInput)
+{
+    for (std::string data : { "+PING\r\n", "*2\r\n$3\r\nGET\r\n:1\r\n", "*1\r\n$-1\r\n", "*1\r\n$3\r\nGETX\r\n" }) {
+        StreamDecoder decoder;
+        decoder.feed(data.data(), data.size());
+        std::vector<std::string_view> args;
+        EXPECT_THROW(decoder.nextCommand(args), std::runtime_error) << data;
+    }
+}
+
+// A bulk length is rejected in its header, before anything is reserved
+// for it: the peer may never send the bytes
+TEST(StreamDecoderTest, OversizedBulkLength)
+{
+    for (std::string length : { "999999999999999999", "4000000000", "536870913" }) {
+        std::string header = "*2\r\n$3\r\nGET\r\n$" + length + "\r\n";
+        StreamDecoder decoder;
+        decoder.feed(header.data(), header.size());
+        std::vector<std::string_view> args;
+        EXPECT_THROW(decoder.nextCommand(args), std::runtime_error) << length;
+        EXPECT_NO_THROW(decoder.feed("abc", 3));
+
+        std::string value = "$" + length + "\r\n";
+        StreamDecoder values;
+        values.feed(value.data(), value.size());
+        EXPECT_THROW(values.next(), std::runtime_error) << length;
+    }
+
+    // The largest accepted length is only reserved for in part
+    std::string header = "*1\r\n$536870912\r\n";
+    StreamDecoder decoder;
+    decoder.feed(header.data(), header.size());
+    std::vector<std::string_view> args;
+    EXPECT_FALSE(decoder.nextCommand(args));
+    EXPECT_NO_THROW(decoder.feed("abc", 3));
+    EXPECT_FALSE(decoder.nextCommand(args));
+}
+
+// Runs fn once per backend this CPU supports, restoring the default after
+template <typename Fn>
+void forEachScanBackend(Fn fn)
+{
+    ScanBackend original = Scanner::backend();
+    for (ScanBackend backend : { ScanBackend::Scalar, ScanBackend::Sse2, ScanBackend::Avx2 }) {
+        if (!Scanner::setBackend(backend))
+            continue;
+        SCOPED_TRACE(Scanner::name(backend));
+        fn();
+    }
+    Scanner::setBackend(original);
+}
+
+TEST(ScannerTest, FindDelimiterMatchesFind)
+{
+    std::mt19937 rng(7);
+    std::vector<std::string> inputs = { "", "\r", "\n", "\r\n", std::string(100, '\r') + "\n", std::string(64, 'a') + "\r\n" };
+    for (int i = 0; i < 500; ++i) {
+        std::string data(rng() % 150, 'a');
+        for (char& c : data)
+            c = "a\r\n"[rng() % 3];
+        inputs.push_back(data);
+    }
+
+    forEachScanBackend([&] {
+        for (const std::string& data : inputs) {
+            for (size_t from = 0; from <= data.size(); ++from)
+                ASSERT_EQ(Scanner::findDelimiter(data.data(), data.size(), from), data.find("\r\n", from)) << from;
+        }
+    });
+}
+
+TEST(ScannerTest, DecodeParity)
+{
+    std::vector<CodecValue> values = {
+        array({ bulk("SET"), bulk("key"), bulk(std::string(100, 'v') + "\r\n" + std::string(100, 'w')) }),
+        array({ bulk("GET"), bulk(std::string(5000, 'k')) }),
+        CodecValue { SimpleString { std::string(70, 's') } }, err("ERR " + std::string(40, 'e')),
+        integer(-1234567890123LL), nullBulk(),
+        array({ array({ integer(1), bulk("") }), array({}), CodecValue { SimpleString { "OK" } } })
+    };
+    std::string data;
+    for (const CodecValue& value : values)
+        data += Codec::encode(value);
+
+    forEachScanBackend([&] {
+        size_t pos = 0;
+        for (const CodecValue& value : values)
+            EXPECT_EQ(Codec::tryDecode(data, pos), value);
+        EXPECT_EQ(pos, data.size());
+
+        // Odd-sized chunks put delimiters at every offset within a block
+        for (size_t chunk : { 1, 7, 33, 4096 }) {
+            StreamDecoder decoder;
+            std::vector<CodecValue> decoded;
+            for (size_t i = 0; i < data.size(); i += chunk) {
+                decoder.feed(data.data() + i, std::min(chunk, data.size() - i));
+                while (std::optional<CodecValue> value = decoder.next())
+                    decoded.push_back(std::move(*value));
+            }
+            EXPECT_EQ(decoded, values) << chunk;
+        }
+
+        EXPECT_THROW(Codec::decode(":12x\r\n"), std::runtime_error);
+        EXPECT_THROW(Codec::decode("*-2\r\n"), std::runtime_error);
+    });
+}
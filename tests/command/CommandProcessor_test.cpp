@@ -1,6 +1,8 @@
 #include "Codec.h"
 #include "CommandProcessor.h"
+#include "CommandTable.h"
 #include "KeyValueStore.h"
+#include "Transaction.h"
 #include <gtest/gtest.h>
 
 using namespace command;
@@ -44,6 +46,52 @@ TEST(CommandProcessor, WrongNumberOfArguments)
     EXPECT_EQ(std::get<Error>(result.data).value, "ERR wrong number of arguments for 'set' command");
 }
 
+TEST(CommandProcessor, ArityCheckedBeforeRunning)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    CodecValue result = processor.process(array({ bulk("get"), bulk("key"), bulk("extra") }));
+    EXPECT_EQ(result, err("ERR wrong number of arguments for 'get' command"));
+    result = processor.process(array({ bulk("LRANGE"), bulk("list") }));
+    EXPECT_EQ(result, err("ERR wrong number of arguments for 'lrange' command"));
+}
+
+TEST(CommandTable, Lookup)
+{
+    for (const CommandSpec& spec : allCommands()) {
+        std::string mixed(spec.name);
+        for (size_t i = 0; i < mixed.size(); i += 2)
+            mixed[i] = static_cast<char>(std::tolower(mixed[i]));
+        EXPECT_EQ(findCommand(spec.name), &spec);
+        EXPECT_EQ(findCommand(mixed), &spec) << mixed;
+        EXPECT_EQ(findCommand(mixed + "X"), nullptr);
+    }
+    EXPECT_EQ(findCommand(""), nullptr);
+    EXPECT_EQ(findCommand("UNKNOWN"), nullptr);
+
+    const CommandSpec* get = findCommand("GET");
+    ASSERT_NE(get, nullptr);
+    EXPECT_TRUE(get->has(CommandSpec::Read));
+    EXPECT_FALSE(get->has(CommandSpec::Write));
+    EXPECT_TRUE(findCommand("SET")->has(CommandSpec::Write));
+
+    std::vector<std::string_view> args = { "HSET", "hash", "field", "value" };
+    std::vector<std::string_view> keys;
+    forEachKey(*findCommand("HSET"), args, [&](std::string_view key) { keys.push_back(key); });
+    EXPECT_EQ(keys, std::vector<std::string_view> { "hash" });
+
+    args = { "SINTERCARD", "2", "a", "b", "LIMIT", "5" };
+    keys.clear();
+    forEachKey(*findCommand("SINTERCARD"), args, [&](std::string_view key) { keys.push_back(key); });
+    EXPECT_EQ(keys, (std::vector<std::string_view> { "a", "b" }));
+
+    args = { "MSET", "k1", "v1", "k2", "v2" };
+    keys.clear();
+    forEachKey(*findCommand("MSET"), args, [&](std::string_view key) { keys.push_back(key); });
+    EXPECT_EQ(keys, (std::vector<std::string_view> { "k1", "k2" }));
+}
+
 // String command tests
 TEST(CommandProcessor, SetAndGet)
 {
@@ -393,6 +441,113 @@ TEST(CommandProcessor, ZAddUpdateScore)
     EXPECT_EQ(std::get<Integer>(result.data).value, 0);
 }
 
+TEST(CommandProcessor, ZAddEqualScores)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    // Members sharing a score are all kept, ordered by member
+    processor.process(array({ bulk("ZADD"), bulk("myzset"), bulk("1"), bulk("b") }));
+    processor.process(array({ bulk("ZADD"), bulk("myzset"), bulk("1"), bulk("a") }));
+    processor.process(array({ bulk("ZADD"), bulk("myzset"), bulk("0"), bulk("c") }));
+    EXPECT_EQ(processor.process(array({ bulk("ZRANGE"), bulk("myzset"), bulk("0"), bulk("-1") })),
+        array({ bulk("c"), bulk("a"), bulk("b") }));
+    EXPECT_EQ(processor.process(array({ bulk("ZADD"), bulk("myzset"), bulk("nan"), bulk("d") })), err("ERR value is not a valid float"));
+}
+
+TEST(CommandProcessor, ZScoreAndRank)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    processor.process(array({ bulk("ZADD"), bulk("board"), bulk("10"), bulk("alice") }));
+    processor.process(array({ bulk("ZADD"), bulk("board"), bulk("20.5"), bulk("bob") }));
+    processor.process(array({ bulk("ZADD"), bulk("board"), bulk("5"), bulk("carol") }));
+
+    EXPECT_EQ(processor.process(array({ bulk("ZSCORE"), bulk("board"), bulk("bob") })), bulk("20.5"));
+    EXPECT_EQ(processor.process(array({ bulk("ZSCORE"), bulk("board"), bulk("dave") })), nullBulk());
+    EXPECT_EQ(processor.process(array({ bulk("ZRANK"), bulk("board"), bulk("alice") })), integer(1));
+    EXPECT_EQ(processor.process(array({ bulk("ZREVRANK"), bulk("board"), bulk("bob") })), integer(0));
+    EXPECT_EQ(processor.process(array({ bulk("ZRANK"), bulk("none"), bulk("bob") })), nullBulk());
+
+    EXPECT_EQ(processor.process(array({ bulk("ZINCRBY"), bulk("board"), bulk("20"), bulk("carol") })), bulk("25"));
+    EXPECT_EQ(processor.process(array({ bulk("ZREVRANGE"), bulk("board"), bulk("0"), bulk("1"), bulk("withscores") })),
+        array({ bulk("carol"), bulk("25"), bulk("bob"), bulk("20.5") }));
+    EXPECT_EQ(processor.process(array({ bulk("ZINCRBY"), bulk("new"), bulk("1.5"), bulk("m") })), bulk("1.5"));
+    processor.process(array({ bulk("ZINCRBY"), bulk("board"), bulk("inf"), bulk("carol") }));
+    EXPECT_EQ(processor.process(array({ bulk("ZINCRBY"), bulk("board"), bulk("-inf"), bulk("carol") })),
+        err("ERR resulting score is not a number (NaN)"));
+    EXPECT_EQ(processor.process(array({ bulk("ZRANGE"), bulk("board"), bulk("0"), bulk("1"), bulk("BAD") })), err("ERR syntax error"));
+}
+
+TEST(CommandProcessor, ZRangeByScoreAndCount)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    for (int i = 1; i <= 5; ++i)
+        processor.process(array({ bulk("ZADD"), bulk("z"), bulk(std::to_string(i)), bulk("m" + std::to_string(i)) }));
+
+    EXPECT_EQ(processor.process(array({ bulk("ZRANGEBYSCORE"), bulk("z"), bulk("2"), bulk("(4") })),
+        array({ bulk("m2"), bulk("m3") }));
+    EXPECT_EQ(processor.process(array({ bulk("ZRANGEBYSCORE"), bulk("z"), bulk("-inf"), bulk("+inf"), bulk("WITHSCORES"),
+                  bulk("LIMIT"), bulk("1"), bulk("2") })),
+        array({ bulk("m2"), bulk("2"), bulk("m3"), bulk("3") }));
+    EXPECT_EQ(processor.process(array({ bulk("ZRANGEBYSCORE"), bulk("z"), bulk("(1"), bulk("inf"), bulk("LIMIT"), bulk("3"),
+                  bulk("-1") })),
+        array({ bulk("m5") }));
+    EXPECT_EQ(processor.process(array({ bulk("ZRANGEBYSCORE"), bulk("z"), bulk("4"), bulk("2") })), array({}));
+    EXPECT_EQ(processor.process(array({ bulk("ZRANGEBYSCORE"), bulk("z"), bulk("x"), bulk("2") })),
+        err("ERR min or max is not a float"));
+    EXPECT_EQ(processor.process(array({ bulk("ZRANGEBYSCORE"), bulk("z"), bulk("1"), bulk("2"), bulk("LIMIT"), bulk("1") })),
+        err("ERR syntax error"));
+
+    EXPECT_EQ(processor.process(array({ bulk("ZCOUNT"), bulk("z"), bulk("(1"), bulk("3") })), integer(2));
+    EXPECT_EQ(processor.process(array({ bulk("ZCOUNT"), bulk("z"), bulk("-inf"), bulk("+inf") })), integer(5));
+    EXPECT_EQ(processor.process(array({ bulk("ZCOUNT"), bulk("none"), bulk("0"), bulk("1") })), integer(0));
+}
+
+TEST(CommandProcessor, MissingKeysAndWrongType)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    // A missing key reads as empty, as in Redis
+    EXPECT_EQ(processor.process(array({ bulk("LRANGE"), bulk("none"), bulk("0"), bulk("-1") })), array({}));
+    EXPECT_EQ(processor.process(array({ bulk("SREM"), bulk("none"), bulk("x") })), integer(0));
+    EXPECT_EQ(processor.process(array({ bulk("HGETALL"), bulk("none") })), array({}));
+
+    processor.process(array({ bulk("SET"), bulk("str"), bulk("value") }));
+    CodecValue wrongType = err("WRONGTYPE Operation against a key holding the wrong kind of value");
+    EXPECT_EQ(processor.process(array({ bulk("LPOP"), bulk("str") })), wrongType);
+    EXPECT_EQ(processor.process(array({ bulk("HGET"), bulk("str"), bulk("f") })), wrongType);
+    EXPECT_EQ(processor.process(array({ bulk("ZRANGE"), bulk("str"), bulk("0"), bulk("1") })), wrongType);
+    // ZINCRBY reads the old score, so it doesn't replace the string
+    EXPECT_EQ(processor.process(array({ bulk("ZINCRBY"), bulk("str"), bulk("1"), bulk("m") })), wrongType);
+    EXPECT_EQ(processor.process(array({ bulk("GET"), bulk("str") })), bulk("value"));
+
+    EXPECT_EQ(processor.process(array({ bulk("LRANGE"), bulk("str"), bulk("x"), bulk("1") })),
+        err("ERR value is not an integer or out of range"));
+    EXPECT_EQ(processor.process(array({ bulk("ZADD"), bulk("z"), bulk("abc"), bulk("m") })), err("ERR value is not a valid float"));
+}
+
+TEST(CommandProcessor, ExecuteArgumentViews)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    std::string input = "set key value";
+    std::vector<std::string_view> args = { std::string_view(input).substr(0, 3), std::string_view(input).substr(4, 3),
+        std::string_view(input).substr(8) };
+    EXPECT_EQ(processor.execute(args), ok());
+
+    // The store keeps its own copy
+    input.assign(input.size(), '?');
+    std::vector<std::string_view> get = { "GET", "key" };
+    EXPECT_EQ(processor.execute(get), bulk("value"));
+    EXPECT_EQ(processor.execute(std::vector<std::string_view> {}), err("ERR empty command"));
+}
+
 // Integration test
 TEST(CommandProcessor, MultipleOperations)
 {
@@ -417,3 +572,213 @@ TEST(CommandProcessor, MultipleOperations)
     ASSERT_TRUE(std::holds_alternative<Array>(result3.data));
     EXPECT_EQ(std::get<Array>(result3.data).elements.size(), 1);
 }
+
+TEST(CommandProcessor, ObjectEncoding)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    processor.process(array({ bulk("HSET"), bulk("user"), bulk("name"), bulk("ann") }));
+    EXPECT_EQ(processor.process(array({ bulk("OBJECT"), bulk("encoding"), bulk("user") })), bulk("listpack"));
+    processor.process(array({ bulk("HSET"), bulk("user"), bulk("bio"), bulk(std::string(65, 'x')) }));
+    EXPECT_EQ(processor.process(array({ bulk("OBJECT"), bulk("ENCODING"), bulk("user") })), bulk("hashtable"));
+
+    processor.process(array({ bulk("SADD"), bulk("tags"), bulk("42") }));
+    EXPECT_EQ(processor.process(array({ bulk("OBJECT"), bulk("ENCODING"), bulk("tags") })), bulk("intset"));
+    EXPECT_EQ(processor.process(array({ bulk("SISMEMBER"), bulk("tags"), bulk("42") })), integer(1));
+    processor.process(array({ bulk("SADD"), bulk("tags"), bulk("a") }));
+    EXPECT_EQ(processor.process(array({ bulk("OBJECT"), bulk("ENCODING"), bulk("tags") })), bulk("listpack"));
+    EXPECT_EQ(processor.process(array({ bulk("SISMEMBER"), bulk("tags"), bulk("42") })), integer(1));
+    EXPECT_EQ(processor.process(array({ bulk("SISMEMBER"), bulk("tags"), bulk("b") })), integer(0));
+    EXPECT_EQ(processor.process(array({ bulk("SISMEMBER"), bulk("none"), bulk("b") })), integer(0));
+    processor.process(array({ bulk("RPUSH"), bulk("jobs"), bulk("a") }));
+    EXPECT_EQ(processor.process(array({ bulk("OBJECT"), bulk("ENCODING"), bulk("jobs") })), bulk("listpack"));
+
+    EXPECT_EQ(processor.process(array({ bulk("OBJECT"), bulk("ENCODING"), bulk("none") })), nullBulk());
+    EXPECT_EQ(processor.process(array({ bulk("OBJECT"), bulk("ENCODING") })),
+        err("ERR wrong number of arguments for 'object|encoding' command"));
+    EXPECT_EQ(processor.process(array({ bulk("OBJECT"), bulk("FREQ"), bulk("user") })),
+        err("ERR unknown subcommand 'FREQ'. Try OBJECT HELP."));
+}
+
+TEST(CommandProcessor, SetAlgebra)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    for (const char* member : { "a", "b", "c" })
+        processor.process(array({ bulk("SADD"), bulk("s1"), bulk(member) }));
+    for (const char* member : { "b", "c", "d" })
+        processor.process(array({ bulk("SADD"), bulk("s2"), bulk(member) }));
+
+    EXPECT_EQ(processor.process(array({ bulk("SDIFF"), bulk("s1"), bulk("s2") })), array({ bulk("a") }));
+    EXPECT_EQ(processor.process(array({ bulk("SINTERSTORE"), bulk("both"), bulk("s1"), bulk("s2") })), integer(2));
+    EXPECT_EQ(processor.process(array({ bulk("SISMEMBER"), bulk("both"), bulk("c") })), integer(1));
+    EXPECT_EQ(processor.process(array({ bulk("SUNIONSTORE"), bulk("all"), bulk("s1"), bulk("s2"), bulk("none") })), integer(4));
+    EXPECT_EQ(processor.process(array({ bulk("SINTER"), bulk("s1"), bulk("none") })), array({}));
+
+    EXPECT_EQ(processor.process(array({ bulk("SINTERCARD"), bulk("2"), bulk("s1"), bulk("s2") })), integer(2));
+    EXPECT_EQ(processor.process(array({ bulk("SINTERCARD"), bulk("2"), bulk("s1"), bulk("s2"), bulk("limit"), bulk("1") })), integer(1));
+    EXPECT_EQ(processor.process(array({ bulk("SINTERCARD"), bulk("0"), bulk("s1") })), err("ERR numkeys should be greater than 0"));
+    EXPECT_EQ(processor.process(array({ bulk("SINTERCARD"), bulk("3"), bulk("s1"), bulk("s2") })),
+        err("ERR Number of keys can't be greater than number of args"));
+    EXPECT_EQ(processor.process(array({ bulk("SINTERCARD"), bulk("1"), bulk("s1"), bulk("LIMIT"), bulk("-1") })),
+        err("ERR LIMIT can't be negative"));
+    EXPECT_EQ(processor.process(array({ bulk("SINTERCARD"), bulk("1"), bulk("s1"), bulk("LIMIT") })), err("ERR syntax error"));
+
+    processor.process(array({ bulk("SET"), bulk("str"), bulk("v") }));
+    EXPECT_EQ(processor.process(array({ bulk("SUNION"), bulk("s1"), bulk("str") })),
+        err("WRONGTYPE Operation against a key holding the wrong kind of value"));
+}
+
+TEST(CommandProcessor, Counters)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    EXPECT_EQ(processor.process(array({ bulk("INCR"), bulk("n") })), integer(1));
+    EXPECT_EQ(processor.process(array({ bulk("INCRBY"), bulk("n"), bulk("41") })), integer(42));
+    EXPECT_EQ(processor.process(array({ bulk("DECRBY"), bulk("n"), bulk("2") })), integer(40));
+    EXPECT_EQ(processor.process(array({ bulk("DECR"), bulk("n") })), integer(39));
+    EXPECT_EQ(processor.process(array({ bulk("OBJECT"), bulk("ENCODING"), bulk("n") })), bulk("int"));
+    EXPECT_EQ(processor.process(array({ bulk("STRLEN"), bulk("n") })), integer(2));
+    EXPECT_EQ(processor.process(array({ bulk("INCRBYFLOAT"), bulk("n"), bulk("0.5") })), bulk("39.5"));
+    EXPECT_EQ(processor.process(array({ bulk("INCR"), bulk("n") })), err("ERR value is not an integer or out of range"));
+    EXPECT_EQ(processor.process(array({ bulk("INCRBY"), bulk("n"), bulk("x") })), err("ERR value is not an integer or out of range"));
+    EXPECT_EQ(processor.process(array({ bulk("INCRBYFLOAT"), bulk("n"), bulk("inf") })),
+        err("ERR increment would produce NaN or Infinity"));
+    EXPECT_EQ(processor.process(array({ bulk("INCRBYFLOAT"), bulk("n"), bulk("x") })), err("ERR value is not a valid float"));
+
+    processor.process(array({ bulk("SET"), bulk("max"), bulk("9223372036854775807") }));
+    EXPECT_EQ(processor.process(array({ bulk("INCR"), bulk("max") })), err("ERR increment or decrement would overflow"));
+    EXPECT_EQ(processor.process(array({ bulk("DECRBY"), bulk("max"), bulk("-9223372036854775808") })),
+        err("ERR decrement would overflow"));
+
+    EXPECT_EQ(processor.process(array({ bulk("APPEND"), bulk("s"), bulk("ab") })), integer(2));
+    EXPECT_EQ(processor.process(array({ bulk("APPEND"), bulk("s"), bulk("cd") })), integer(4));
+    EXPECT_EQ(processor.process(array({ bulk("GET"), bulk("s") })), bulk("abcd"));
+    EXPECT_EQ(processor.process(array({ bulk("STRLEN"), bulk("none") })), integer(0));
+    processor.process(array({ bulk("LPUSH"), bulk("l"), bulk("a") }));
+    EXPECT_EQ(processor.process(array({ bulk("STRLEN"), bulk("l") })),
+        err("WRONGTYPE Operation against a key holding the wrong kind of value"));
+    for (auto command : { array({ bulk("INCR"), bulk("l") }), array({ bulk("DECRBY"), bulk("l"), bulk("2") }),
+             array({ bulk("INCRBYFLOAT"), bulk("l"), bulk("1.5") }), array({ bulk("APPEND"), bulk("l"), bulk("b") }) })
+        EXPECT_EQ(processor.process(command), err("WRONGTYPE Operation against a key holding the wrong kind of value"));
+    EXPECT_EQ(processor.process(array({ bulk("LRANGE"), bulk("l"), bulk("0"), bulk("-1") })), array({ bulk("a") }));
+
+    processor.process(array({ bulk("INCRBYFLOAT"), bulk("f"), bulk("0.1") }));
+    EXPECT_EQ(processor.process(array({ bulk("INCRBYFLOAT"), bulk("f"), bulk("0.2") })), bulk("0.3"));
+}
+
+TEST(CommandProcessor, VariadicCommands)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+
+    EXPECT_EQ(processor.process(array({ bulk("MSET"), bulk("a"), bulk("1"), bulk("b"), bulk("2") })), ok());
+    EXPECT_EQ(processor.process(array({ bulk("MSET"), bulk("a"), bulk("1"), bulk("b") })),
+        err("ERR wrong number of arguments for 'mset' command"));
+    EXPECT_EQ(processor.process(array({ bulk("MGET"), bulk("a"), bulk("none"), bulk("b") })),
+        array({ bulk("1"), nullBulk(), bulk("2") }));
+    EXPECT_EQ(processor.process(array({ bulk("EXISTS"), bulk("a"), bulk("b"), bulk("none") })), integer(2));
+    EXPECT_EQ(processor.process(array({ bulk("DEL"), bulk("a"), bulk("b"), bulk("none") })), integer(2));
+
+    EXPECT_EQ(processor.process(array({ bulk("RPUSH"), bulk("l"), bulk("a"), bulk("b"), bulk("c") })), integer(3));
+    EXPECT_EQ(processor.process(array({ bulk("LPUSH"), bulk("l"), bulk("x"), bulk("y") })), integer(5));
+    EXPECT_EQ(processor.process(array({ bulk("LPOP"), bulk("l"), bulk("2") })), array({ bulk("y"), bulk("x") }));
+    EXPECT_EQ(processor.process(array({ bulk("RPOP"), bulk("l"), bulk("0") })), array({}));
+    EXPECT_EQ(processor.process(array({ bulk("RPOP"), bulk("l") })), bulk("c"));
+    EXPECT_EQ(processor.process(array({ bulk("RPOP"), bulk("l"), bulk("-1") })),
+        err("ERR value is out of range, must be positive"));
+    EXPECT_EQ(processor.process(array({ bulk("LPOP"), bulk("l"), bulk("1"), bulk("2") })),
+        err("ERR wrong number of arguments for 'lpop' command"));
+    EXPECT_EQ(processor.process(array({ bulk("LPOP"), bulk("l"), bulk("5") })), array({ bulk("a"), bulk("b") }));
+    EXPECT_EQ(processor.process(array({ bulk("LPOP"), bulk("l"), bulk("5") })), nullArray());
+
+    EXPECT_EQ(processor.process(array({ bulk("SADD"), bulk("s"), bulk("a"), bulk("b"), bulk("a") })), integer(2));
+    EXPECT_EQ(processor.process(array({ bulk("SREM"), bulk("s"), bulk("a"), bulk("c") })), integer(1));
+
+    EXPECT_EQ(processor.process(array({ bulk("HSET"), bulk("h"), bulk("f1"), bulk("v1"), bulk("f2"), bulk("v2") })), integer(2));
+    EXPECT_EQ(processor.process(array({ bulk("HSET"), bulk("h"), bulk("f1"), bulk("v1"), bulk("f2") })),
+        err("ERR wrong number of arguments for 'hset' command"));
+    EXPECT_EQ(processor.process(array({ bulk("HMGET"), bulk("h"), bulk("f2"), bulk("f3") })), array({ bulk("v2"), nullBulk() }));
+    EXPECT_EQ(processor.process(array({ bulk("HMGET"), bulk("none"), bulk("f1") })), array({ nullBulk() }));
+    EXPECT_EQ(processor.process(array({ bulk("HDEL"), bulk("h"), bulk("f1"), bulk("f2"), bulk("f3") })), integer(2));
+
+    EXPECT_EQ(processor.process(array({ bulk("ZADD"), bulk("z"), bulk("1"), bulk("a"), bulk("2"), bulk("b") })), integer(2));
+    // A bad score anywhere adds nothing
+    EXPECT_EQ(processor.process(array({ bulk("ZADD"), bulk("z"), bulk("3"), bulk("c"), bulk("x"), bulk("d") })),
+        err("ERR value is not a valid float"));
+    EXPECT_EQ(processor.process(array({ bulk("ZADD"), bulk("z"), bulk("3"), bulk("c"), bulk("4") })), err("ERR syntax error"));
+    EXPECT_EQ(processor.process(array({ bulk("ZREM"), bulk("z"), bulk("a"), bulk("b"), bulk("c") })), integer(2));
+    EXPECT_EQ(processor.process(array({ bulk("EXISTS"), bulk("z") })), integer(0));
+}
+
+TEST(CommandProcessor, TransactionQueue)
+{
+    Transaction transaction;
+    EXPECT_FALSE(transaction.active());
+    transaction.begin();
+    std::vector<std::string> buffer = { "SET", "k", "v", "INCR", "n" };
+    std::vector<std::string_view> set(buffer.begin(), buffer.begin() + 3);
+    std::vector<std::string_view> incr(buffer.begin() + 3, buffer.end());
+    EXPECT_EQ(transaction.queue(set), CodecValue { SimpleString { "QUEUED" } });
+    EXPECT_EQ(transaction.queue(incr), CodecValue { SimpleString { "QUEUED" } });
+    // Queued arguments are copies, so the client's buffer can move on
+    buffer.assign(5, "x");
+    EXPECT_EQ(transaction.args(), (std::vector<std::string_view> { "SET", "k", "v", "INCR", "n" }));
+    EXPECT_EQ(std::vector<size_t>(transaction.requests().begin(), transaction.requests().end()),
+        (std::vector<size_t> { 3, 2 }));
+    EXPECT_FALSE(transaction.failed());
+
+    std::vector<std::string_view> unknown = { "NOPE" };
+    EXPECT_EQ(transaction.queue(unknown), err("ERR unknown command 'NOPE'"));
+    std::vector<std::string_view> arity = { "GET" };
+    EXPECT_EQ(transaction.queue(arity), err("ERR wrong number of arguments for 'get' command"));
+    EXPECT_TRUE(transaction.failed());
+    EXPECT_EQ(transaction.requests().size(), 2u);
+
+    transaction.clear();
+    EXPECT_FALSE(transaction.active());
+    EXPECT_FALSE(transaction.failed());
+    EXPECT_TRUE(transaction.requests().empty());
+}
+
+TEST(CommandProcessor, WatchAndExec)
+{
+    KeyValueStore store;
+    CommandProcessor processor(store);
+    std::vector<std::string_view> args = { "INCR", "n", "INCRBY", "n", "10", "GET", "n" };
+    std::vector<size_t> requests = { 2, 3, 2 };
+    std::vector<std::string_view> keys = { "n", "other" };
+
+    EXPECT_EQ(processor.exec(1, args, requests), array({ integer(1), integer(11), bulk("11") }));
+
+    // A write to a watched key by anyone spoils the watch
+    processor.watch(1, keys);
+    processor.watch(2, keys);
+    processor.process(array({ bulk("SET"), bulk("other"), bulk("x") }));
+    EXPECT_EQ(processor.exec(1, args, requests), nullArray());
+    EXPECT_EQ(*store.get("n"), "11");
+    // ...and exec releases the watches whether or not it ran
+    EXPECT_EQ(processor.exec(1, args, requests), array({ integer(12), integer(22), bulk("22") }));
+
+    // Reads don't, and neither do writes to other keys
+    processor.watch(3, keys);
+    processor.process(array({ bulk("GET"), bulk("n") }));
+    processor.process(array({ bulk("SET"), bulk("unwatched"), bulk("x") }));
+    EXPECT_EQ(processor.exec(3, {}, {}), array({}));
+
+    // A transaction's own writes spoil other watchers, not itself
+    processor.watch(4, keys);
+    processor.watch(5, keys);
+    EXPECT_EQ(processor.exec(4, args, requests), array({ integer(23), integer(33), bulk("33") }));
+    EXPECT_EQ(processor.exec(5, {}, {}), nullArray());
+
+    processor.unwatch(2);
+    processor.process(array({ bulk("DEL"), bulk("n") }));
+    EXPECT_EQ(processor.exec(2, {}, {}), array({}));
+
+    EXPECT_EQ(processor.process(array({ bulk("MULTI") })), err("ERR multi is only valid on a connection"));
+    EXPECT_EQ(processor.process(array({ bulk("UNWATCH") })), ok());
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "Server.h"
+#include "IoThreadPool.h"
 #include "Codec.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -9,6 +10,8 @@
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <optional>
+#include <vector>
 
 using namespace server;
 using namespace codec;
@@ -35,6 +38,27 @@ namespace {
         close(sock);
         return -1;
     }
+
+    std::vector<CodecValue> receiveReplies(int sock, size_t count) {
+        std::vector<CodecValue> replies;
+        std::string data;
+        size_t pos = 0;
+        char buffer[4096];
+
+        while (replies.size() < count) {
+            std::optional<CodecValue> reply = Codec::tryDecode(data, pos);
+            if (reply) {
+                replies.push_back(*reply);
+                continue;
+            }
+            ssize_t received = recv(sock, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                break;
+            }
+            data.append(buffer, received);
+        }
+        return replies;
+    }
 }
 
 TEST(SimpleServerTest, TwoCommands) {
@@ -88,3 +112,446 @@ TEST(SimpleServerTest, TwoCommands) {
     server.stop();
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
 }
+
+TEST(SimpleServerTest, PipelinedCommands) {
+    constexpr int TEST_PORT = 9998;
+    constexpr int COMMANDS = 100;
+
+    Server server(TEST_PORT);
+    ASSERT_TRUE(server.start());
+
+    std::thread serverThread([&server]() {
+        server.run();
+    });
+    serverThread.detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int sock = connectToServer(TEST_PORT);
+    ASSERT_NE(sock, -1) << "Failed to connect to server";
+
+    std::string batch;
+    for (int i = 0; i < COMMANDS; ++i) {
+        batch += Codec::encode(array({bulk("SET"), bulk("key" + std::to_string(i)), bulk("value" + std::to_string(i))}));
+        batch += Codec::encode(array({bulk("GET"), bulk("key" + std::to_string(i))}));
+    }
+
+    // Split the batch mid-frame so the server has to hold on to a partial command
+    size_t split = batch.size() / 2 + 3;
+    ASSERT_EQ(send(sock, batch.data(), split, 0), static_cast<ssize_t>(split));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(send(sock, batch.data() + split, batch.size() - split, 0), static_cast<ssize_t>(batch.size() - split));
+
+    std::vector<CodecValue> replies = receiveReplies(sock, 2 * COMMANDS);
+    ASSERT_EQ(replies.size(), 2u * COMMANDS);
+    for (int i = 0; i < COMMANDS; ++i) {
+        EXPECT_EQ(replies[2 * i], ok());
+        EXPECT_EQ(replies[2 * i + 1], bulk("value" + std::to_string(i)));
+    }
+
+    close(sock);
+    server.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+TEST(SimpleServerTest, SlowReaderDoesNotStallOthers) {
+    constexpr int TEST_PORT = 9997;
+    constexpr int GETS = 8;
+
+    Server server(TEST_PORT);
+    ASSERT_TRUE(server.start());
+
+    std::thread serverThread([&server]() {
+        server.run();
+    });
+    serverThread.detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int slow = connectToServer(TEST_PORT);
+    ASSERT_NE(slow, -1) << "Failed to connect to server";
+
+    // Queue far more reply bytes than the socket buffers hold, without reading
+    std::string value(4 << 20, 'v');
+    std::string batch = Codec::encode(array({bulk("SET"), bulk("big"), bulk(value)}));
+    for (int i = 0; i < GETS; ++i) {
+        batch += Codec::encode(array({bulk("GET"), bulk("big")}));
+    }
+    std::thread writer([&]() {
+        send(slow, batch.data(), batch.size(), 0);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    int fast = connectToServer(TEST_PORT);
+    ASSERT_NE(fast, -1) << "Failed to connect to server";
+    timeval timeout{2, 0};
+    setsockopt(fast, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string ping = Codec::encode(array({bulk("SET"), bulk("small"), bulk("1")}));
+    ASSERT_EQ(send(fast, ping.data(), ping.size(), 0), static_cast<ssize_t>(ping.size()));
+    std::vector<CodecValue> fastReplies = receiveReplies(fast, 1);
+    ASSERT_EQ(fastReplies.size(), 1u) << "Server stalled behind a slow reader";
+    EXPECT_EQ(fastReplies[0], ok());
+
+    std::vector<CodecValue> slowReplies = receiveReplies(slow, GETS + 1);
+    writer.join();
+    ASSERT_EQ(slowReplies.size(), static_cast<size_t>(GETS + 1));
+    EXPECT_EQ(slowReplies[0], ok());
+    for (int i = 1; i <= GETS; ++i) {
+        EXPECT_EQ(slowReplies[i], bulk(value));
+    }
+
+    close(fast);
+    close(slow);
+    server.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+TEST(SimpleServerTest, MultiReactorSharding) {
+    constexpr int TEST_PORT = 9996;
+    constexpr int CLIENTS = 4;
+    constexpr int KEYS = 200;
+
+    Server server(TEST_PORT, 4);
+    ASSERT_TRUE(server.start());
+
+    std::thread serverThread([&server]() {
+        server.run();
+    });
+    serverThread.detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Connections land on different reactors and keys on different shards, so
+    // most commands are forwarded; replies must still come back in order
+    std::vector<int> socks;
+    for (int c = 0; c < CLIENTS; ++c) {
+        int sock = connectToServer(TEST_PORT);
+        ASSERT_NE(sock, -1) << "Failed to connect to server";
+        socks.push_back(sock);
+
+        std::string batch;
+        for (int i = 0; i < KEYS; ++i) {
+            std::string key = "c" + std::to_string(c) + ":k" + std::to_string(i);
+            batch += Codec::encode(array({bulk("SET"), bulk(key), bulk(std::to_string(i))}));
+            batch += Codec::encode(array({bulk("GET"), bulk(key)}));
+        }
+        ASSERT_EQ(send(sock, batch.data(), batch.size(), 0), static_cast<ssize_t>(batch.size()));
+
+        std::vector<CodecValue> replies = receiveReplies(sock, 2 * KEYS);
+        ASSERT_EQ(replies.size(), 2u * KEYS);
+        for (int i = 0; i < KEYS; ++i) {
+            EXPECT_EQ(replies[2 * i], ok());
+            EXPECT_EQ(replies[2 * i + 1], bulk(std::to_string(i)));
+        }
+    }
+
+    // Every client sees keys written through every other client
+    for (int c = 0; c < CLIENTS; ++c) {
+        std::string batch;
+        int writer = (c + 1) % CLIENTS;
+        for (int i = 0; i < KEYS; ++i) {
+            batch += Codec::encode(array({bulk("GET"), bulk("c" + std::to_string(writer) + ":k" + std::to_string(i))}));
+        }
+        ASSERT_EQ(send(socks[c], batch.data(), batch.size(), 0), static_cast<ssize_t>(batch.size()));
+
+        std::vector<CodecValue> replies = receiveReplies(socks[c], KEYS);
+        ASSERT_EQ(replies.size(), static_cast<size_t>(KEYS));
+        for (int i = 0; i < KEYS; ++i) {
+            EXPECT_EQ(replies[i], bulk(std::to_string(i)));
+        }
+    }
+
+    for (int sock : socks) {
+        close(sock);
+    }
+    server.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+TEST(SimpleServerTest, IoThreads) {
+    constexpr int TEST_PORT = 9995;
+    constexpr int CLIENTS = 8;
+    constexpr int KEYS = 100;
+
+    Server server(TEST_PORT, 1, 3);
+    ASSERT_TRUE(server.start());
+
+    std::thread serverThread([&server]() {
+        server.run();
+    });
+    serverThread.detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Clients send at the same time so batches hold several connections
+    std::vector<std::thread> clients;
+    std::atomic<int> verified{0};
+    for (int c = 0; c < CLIENTS; ++c) {
+        clients.emplace_back([&, c]() {
+            int sock = connectToServer(TEST_PORT);
+            if (sock == -1) {
+                return;
+            }
+            std::string batch;
+            for (int i = 0; i < KEYS; ++i) {
+                std::string key = "c" + std::to_string(c) + ":" + std::to_string(i);
+                batch += Codec::encode(array({bulk("RPUSH"), bulk("list" + std::to_string(c)), bulk(key)}));
+                batch += Codec::encode(array({bulk("SET"), bulk(key), bulk(key)}));
+                batch += Codec::encode(array({bulk("GET"), bulk(key)}));
+            }
+            send(sock, batch.data(), batch.size(), 0);
+
+            std::vector<CodecValue> replies = receiveReplies(sock, 3 * KEYS);
+            bool ok = replies.size() == 3u * KEYS;
+            for (int i = 0; ok && i < KEYS; ++i) {
+                std::string key = "c" + std::to_string(c) + ":" + std::to_string(i);
+                ok = replies[3 * i] == integer(i + 1) && replies[3 * i + 1] == codec::ok()
+                    && replies[3 * i + 2] == bulk(key);
+            }
+            if (ok) {
+                ++verified;
+            }
+            close(sock);
+        });
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    EXPECT_EQ(verified.load(), CLIENTS);
+
+    server.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+// A throw on the calling thread must not unwind while workers still run fn
+TEST(IoThreadPoolTest, ThrowWaitsForWorkers) {
+    IoThreadPool pool(3);
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<int> running{0};
+    auto fn = [&](size_t) {
+        if (std::this_thread::get_id() == caller) {
+            throw std::runtime_error("failed");
+        }
+        ++running;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        --running;
+    };
+    EXPECT_THROW(pool.parallelFor(64, fn), std::runtime_error);
+    EXPECT_EQ(running.load(), 0);
+
+    // The pool is still usable afterwards
+    std::atomic<size_t> sum{0};
+    pool.parallelFor(100, [&](size_t i) {
+        sum += i;
+    });
+    EXPECT_EQ(sum.load(), 4950u);
+}
+
+TEST(SimpleServerTest, IoUringBackend) {
+    constexpr int TEST_PORT = 9994;
+    constexpr int KEYS = 500;
+
+    Server server(TEST_PORT, 2, 2, EventLoop::Backend::IoUring);
+    ASSERT_TRUE(server.start());
+
+    std::thread serverThread([&server]() {
+        server.run();
+    });
+    serverThread.detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int sock = connectToServer(TEST_PORT);
+    ASSERT_NE(sock, -1) << "Failed to connect to server";
+
+    // Enough pipelined input to span many provided buffers, plus a reply
+    // larger than one send
+    std::string value(1 << 20, 'u');
+    std::string batch = Codec::encode(array({bulk("SET"), bulk("big"), bulk(value)}));
+    for (int i = 0; i < KEYS; ++i) {
+        batch += Codec::encode(array({bulk("SET"), bulk("k" + std::to_string(i)), bulk(std::to_string(i))}));
+        batch += Codec::encode(array({bulk("GET"), bulk("k" + std::to_string(i))}));
+    }
+    batch += Codec::encode(array({bulk("GET"), bulk("big")}));
+
+    std::thread writer([&]() {
+        send(sock, batch.data(), batch.size(), 0);
+    });
+    std::vector<CodecValue> replies = receiveReplies(sock, 2 * KEYS + 2);
+    writer.join();
+
+    ASSERT_EQ(replies.size(), 2u * KEYS + 2);
+    EXPECT_EQ(replies[0], ok());
+    for (int i = 0; i < KEYS; ++i) {
+        EXPECT_EQ(replies[1 + 2 * i], ok());
+        EXPECT_EQ(replies[2 + 2 * i], bulk(std::to_string(i)));
+    }
+    EXPECT_EQ(replies.back(), bulk(value));
+
+    // A second client after the first has gone away
+    close(sock);
+    sock = connectToServer(TEST_PORT);
+    ASSERT_NE(sock, -1) << "Failed to connect to server";
+    std::string get = Codec::encode(array({bulk("GET"), bulk("k7")}));
+    ASSERT_EQ(send(sock, get.data(), get.size(), 0), static_cast<ssize_t>(get.size()));
+    replies = receiveReplies(sock, 1);
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0], bulk("7"));
+
+    close(sock);
+    server.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+TEST(SimpleServerTest, MultiExecAcrossShards) {
+    constexpr int TEST_PORT = 9993;
+    constexpr size_t REACTORS = 4;
+
+    Server server(TEST_PORT, REACTORS);
+    ASSERT_TRUE(server.start());
+
+    std::thread serverThread([&server]() {
+        server.run();
+    });
+    serverThread.detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int sock = connectToServer(TEST_PORT);
+    int other = connectToServer(TEST_PORT);
+    ASSERT_NE(sock, -1) << "Failed to connect to server";
+    ASSERT_NE(other, -1) << "Failed to connect to server";
+
+    auto run = [](int s, const std::vector<CodecValue>& commands) {
+        std::string batch;
+        for (const CodecValue& command : commands) {
+            batch += Codec::encode(command);
+        }
+        EXPECT_EQ(send(s, batch.data(), batch.size(), 0), static_cast<ssize_t>(batch.size()));
+        return receiveReplies(s, commands.size());
+    };
+    const CodecValue queued{SimpleString{"QUEUED"}};
+
+    // Keys on two different shards
+    std::string key = "tx:0";
+    std::string elsewhere;
+    for (int i = 1; elsewhere.empty(); ++i) {
+        std::string candidate = "tx:" + std::to_string(i);
+        if (Reactor::shardOf(candidate, REACTORS) != Reactor::shardOf(key, REACTORS)) {
+            elsewhere = candidate;
+        }
+    }
+
+    std::vector<CodecValue> replies = run(sock, {
+        array({bulk("WATCH"), bulk(key)}),
+        array({bulk("MULTI")}),
+        array({bulk("INCR"), bulk(key)}),
+        array({bulk("INCRBY"), bulk(key), bulk("9")}),
+        array({bulk("EXEC")}),
+    });
+    ASSERT_EQ(replies.size(), 5u);
+    EXPECT_EQ(replies[0], ok());
+    EXPECT_EQ(replies[1], ok());
+    EXPECT_EQ(replies[2], queued);
+    EXPECT_EQ(replies[3], queued);
+    EXPECT_EQ(replies[4], array({integer(1), integer(10)}));
+
+    // Another client's write between WATCH and EXEC aborts the transaction
+    replies = run(sock, {array({bulk("WATCH"), bulk(key)})});
+    EXPECT_EQ(replies, std::vector<CodecValue>{ok()});
+    replies = run(other, {array({bulk("SET"), bulk(key), bulk("100")})});
+    EXPECT_EQ(replies, std::vector<CodecValue>{ok()});
+    replies = run(sock, {
+        array({bulk("MULTI")}),
+        array({bulk("INCR"), bulk(key)}),
+        array({bulk("EXEC")}),
+        array({bulk("GET"), bulk(key)}),
+    });
+    ASSERT_EQ(replies.size(), 4u);
+    EXPECT_EQ(replies[2], nullArray());
+    EXPECT_EQ(replies[3], bulk("100"));
+
+    // Errors found while queuing, including keys on another shard, fail EXEC
+    replies = run(sock, {
+        array({bulk("MULTI")}),
+        array({bulk("SET"), bulk(key), bulk("1")}),
+        array({bulk("SET"), bulk(elsewhere), bulk("1")}),
+        array({bulk("GET")}),
+        array({bulk("EXEC")}),
+        array({bulk("GET"), bulk(key)}),
+    });
+    ASSERT_EQ(replies.size(), 6u);
+    EXPECT_EQ(replies[1], queued);
+    EXPECT_EQ(replies[2], err("CROSSSLOT Keys in request don't hash to the same slot"));
+    EXPECT_EQ(replies[3], err("ERR wrong number of arguments for 'get' command"));
+    EXPECT_EQ(replies[4], err("EXECABORT Transaction discarded because of previous errors."));
+    EXPECT_EQ(replies[5], bulk("100"));
+
+    replies = run(sock, {
+        array({bulk("EXEC")}),
+        array({bulk("MULTI")}),
+        array({bulk("MULTI")}),
+        array({bulk("SET"), bulk(elsewhere), bulk("1")}),
+        array({bulk("DISCARD")}),
+        array({bulk("DISCARD")}),
+        array({bulk("EXISTS"), bulk(elsewhere)}),
+    });
+    ASSERT_EQ(replies.size(), 7u);
+    EXPECT_EQ(replies[0], err("ERR EXEC without MULTI"));
+    EXPECT_EQ(replies[2], err("ERR MULTI calls can not be nested"));
+    EXPECT_EQ(replies[4], ok());
+    EXPECT_EQ(replies[5], err("ERR DISCARD without MULTI"));
+    EXPECT_EQ(replies[6], integer(0));
+
+    close(sock);
+    close(other);
+    server.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+TEST(SimpleServerTest, HashTagsKeepKeysTogether) {
+    constexpr int TEST_PORT = 9992;
+    constexpr size_t REACTORS = 4;
+
+    // Only a non-empty {tag} is hashed, so these share a shard
+    EXPECT_EQ(Reactor::shardOf("{user:1}:name", REACTORS), Reactor::shardOf("user:1", REACTORS));
+    EXPECT_EQ(Reactor::shardOf("a{user:1}", REACTORS), Reactor::shardOf("b{user:1}}", REACTORS));
+    size_t spread = 0;
+    for (int i = 0; i < 100; ++i) {
+        spread += Reactor::shardOf("{}" + std::to_string(i), REACTORS) != Reactor::shardOf("{}", REACTORS);
+    }
+    EXPECT_GT(spread, 0u) << "an empty tag hashes the whole key";
+
+    Server server(TEST_PORT, REACTORS);
+    ASSERT_TRUE(server.start());
+
+    std::thread serverThread([&server]() {
+        server.run();
+    });
+    serverThread.detach();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int sock = connectToServer(TEST_PORT);
+    ASSERT_NE(sock, -1) << "Failed to connect to server";
+
+    std::vector<CodecValue> mset = {bulk("MSET")};
+    std::vector<CodecValue> mget = {bulk("MGET")};
+    for (int i = 0; i < 20; ++i) {
+        std::string key = "{user:1}:" + std::to_string(i);
+        mset.push_back(bulk(key));
+        mset.push_back(bulk(std::to_string(i)));
+        mget.push_back(bulk(key));
+    }
+    std::string batch = Codec::encode(array(mset)) + Codec::encode(array(mget))
+        + Codec::encode(array({bulk("DEL"), bulk("{user:1}:0"), bulk("{user:1}:1"), bulk("{user:1}:missing")}));
+    ASSERT_EQ(send(sock, batch.data(), batch.size(), 0), static_cast<ssize_t>(batch.size()));
+
+    std::vector<CodecValue> replies = receiveReplies(sock, 3);
+    ASSERT_EQ(replies.size(), 3u);
+    EXPECT_EQ(replies[0], ok());
+    std::vector<CodecValue> values;
+    for (int i = 0; i < 20; ++i) {
+        values.push_back(bulk(std::to_string(i)));
+    }
+    EXPECT_EQ(replies[1], array(values));
+    EXPECT_EQ(replies[2], integer(2));
+
+    close(sock);
+    server.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
@@ -1,5 +1,19 @@
+#include "storage/Dict.h"
+#include "storage/FlatHashMap.h"
+#include "storage/IntSet.h"
 #include "storage/KeyValueStore.h"
+#include "storage/QuickList.h"
+#include <algorithm>
+#include <chrono>
 #include <gtest/gtest.h>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <unordered_map>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 
 using namespace storage;
 
@@ -8,11 +22,56 @@ TEST(KeyValueStoreTest, StringSetGetExistsDel)
 {
     KeyValueStore kv;
     kv.set("foo", "bar");
-    EXPECT_EQ(kv.get("foo"), "bar");
+    EXPECT_EQ(*kv.get("foo"), "bar");
     EXPECT_TRUE(kv.exists("foo"));
     EXPECT_TRUE(kv.del("foo"));
     EXPECT_FALSE(kv.exists("foo"));
-    EXPECT_THROW(kv.get("foo"), std::runtime_error);
+    EXPECT_EQ(kv.get("foo").error(), StoreError::NoKey);
+}
+
+TEST(KeyValueStoreTest, Counters)
+{
+    KeyValueStore kv;
+    EXPECT_EQ(*kv.incrby("hits", 1), 1);
+    EXPECT_EQ(*kv.incrby("hits", -11), -10);
+    EXPECT_STREQ(*kv.encoding("hits"), "int");
+    EXPECT_EQ(*kv.get("hits"), "-10");
+    EXPECT_EQ(*kv.strlen("hits"), 3u);
+
+    kv.set("max", "9223372036854775807");
+    EXPECT_EQ(kv.incrby("max", 1).error(), StoreError::OutOfRange);
+    EXPECT_EQ(*kv.get("max"), "9223372036854775807");
+    kv.set("text", "007");
+    EXPECT_EQ(kv.incrby("text", 1).error(), StoreError::NotNumber);
+
+    EXPECT_EQ(*kv.incrbyfloat("price", 10.5), "10.5");
+    EXPECT_EQ(*kv.incrbyfloat("price", 0.25), "10.75");
+    EXPECT_EQ(*kv.incrbyfloat("price", -0.75), "10");
+    EXPECT_STREQ(*kv.encoding("price"), "int");
+    EXPECT_EQ(*kv.incrbyfloat("large", 1e20L), "100000000000000000000");
+    kv.set("text", "abc");
+    EXPECT_EQ(kv.incrbyfloat("text", 1).error(), StoreError::NotNumber);
+    EXPECT_EQ(kv.incrbyfloat("new", INFINITY).error(), StoreError::OutOfRange);
+    EXPECT_FALSE(kv.exists("new"));
+    // Summed in long double and rounded to 17 decimals, as in Redis
+    EXPECT_EQ(*kv.incrbyfloat("sum", 0.1L), "0.1");
+    EXPECT_EQ(*kv.incrbyfloat("sum", 0.2L), "0.3");
+    EXPECT_EQ(*kv.incrbyfloat("sum", -0.3L), "0");
+
+    EXPECT_EQ(*kv.append("log", "hello"), 5u);
+    EXPECT_EQ(*kv.append("log", " world, appended"), 21u);
+    EXPECT_EQ(*kv.get("log"), "hello world, appended");
+    EXPECT_STREQ(*kv.encoding("log"), "raw");
+    EXPECT_EQ(*kv.append("hits", "5"), 4u);
+    EXPECT_EQ(*kv.incrby("hits", 1), -104);
+    EXPECT_EQ(kv.strlen("missing").error(), StoreError::NoKey);
+
+    // They read the old value, so a collection is refused, not replaced
+    kv.rpush("list", "a");
+    EXPECT_EQ(kv.incrby("list", 1).error(), StoreError::WrongType);
+    EXPECT_EQ(kv.incrbyfloat("list", 1).error(), StoreError::WrongType);
+    EXPECT_EQ(kv.append("list", "b").error(), StoreError::WrongType);
+    EXPECT_EQ(*kv.lrange("list", 0, -1), std::vector<std::string> { "a" });
 }
 
 // List operations
@@ -23,18 +82,18 @@ TEST(KeyValueStoreTest, ListPushPopRange)
     kv.rpush("mylist", "b");
     kv.lpush("mylist", "c");
     // mylist: c, a, b
-    auto vals = kv.lrange("mylist", 0, -1);
+    auto vals = *kv.lrange("mylist", 0, -1);
     ASSERT_EQ(vals.size(), 3);
     EXPECT_EQ(vals[0], "c");
     EXPECT_EQ(vals[1], "a");
     EXPECT_EQ(vals[2], "b");
-    EXPECT_EQ(kv.lpop("mylist"), "c");
-    EXPECT_EQ(kv.rpop("mylist"), "b");
-    vals = kv.lrange("mylist", 0, -1);
+    EXPECT_EQ(*kv.lpop("mylist"), "c");
+    EXPECT_EQ(*kv.rpop("mylist"), "b");
+    vals = *kv.lrange("mylist", 0, -1);
     ASSERT_EQ(vals.size(), 1);
     EXPECT_EQ(vals[0], "a");
-    EXPECT_EQ(kv.lpop("mylist"), "a");
-    EXPECT_THROW(kv.lpop("mylist"), std::runtime_error); // after popping last element
+    EXPECT_EQ(*kv.lpop("mylist"), "a");
+    EXPECT_EQ(kv.lpop("mylist").error(), StoreError::NoKey); // after popping last element
 }
 
 // Set operations
@@ -44,15 +103,13 @@ TEST(KeyValueStoreTest, SetAddRemoveMembers)
     kv.sadd("myset", "x");
     kv.sadd("myset", "y");
     kv.sadd("myset", "z");
-    auto members = kv.smembers("myset");
-    EXPECT_EQ(members.size(), 3);
-    EXPECT_TRUE(members.count("x"));
-    EXPECT_TRUE(members.count("y"));
-    EXPECT_TRUE(members.count("z"));
+    auto members = *kv.smembers("myset");
+    std::sort(members.begin(), members.end());
+    EXPECT_EQ(members, (std::vector<std::string> { "x", "y", "z" }));
     kv.srem("myset", "y");
-    members = kv.smembers("myset");
+    members = *kv.smembers("myset");
     EXPECT_EQ(members.size(), 2);
-    EXPECT_FALSE(members.count("y"));
+    EXPECT_EQ(std::find(members.begin(), members.end(), "y"), members.end());
 }
 
 // Hash operations
@@ -61,16 +118,18 @@ TEST(KeyValueStoreTest, HashSetGetDelAll)
     KeyValueStore kv;
     EXPECT_TRUE(kv.hset("myhash", "field1", "val1"));
     EXPECT_FALSE(kv.hset("myhash", "field1", "val2")); // overwrite
-    EXPECT_EQ(kv.hget("myhash", "field1"), "val2");
-    EXPECT_TRUE(kv.hdel("myhash", "field1"));
-    EXPECT_FALSE(kv.hdel("myhash", "field1"));
+    EXPECT_EQ(*kv.hget("myhash", "field1"), "val2");
+    EXPECT_TRUE(*kv.hdel("myhash", "field1"));
+    // Removing the last field removed the key
+    EXPECT_EQ(kv.hdel("myhash", "field1").error(), StoreError::NoKey);
     kv.hset("myhash", "a", "1");
     kv.hset("myhash", "b", "2");
-    auto all = kv.hgetall("myhash");
+    auto entries = *kv.hgetall("myhash");
+    std::map<std::string, std::string> all(entries.begin(), entries.end());
     EXPECT_EQ(all.size(), 2);
     EXPECT_EQ(all["a"], "1");
     EXPECT_EQ(all["b"], "2");
-    EXPECT_THROW(kv.hget("myhash", "field1"), std::runtime_error);
+    EXPECT_EQ(kv.hget("myhash", "field1").error(), StoreError::NoKey);
 }
 
 // Sorted Set operations
@@ -80,17 +139,17 @@ TEST(KeyValueStoreTest, ZSetAddRemoveRange)
     kv.zadd("myzset", 1.0, "one");
     kv.zadd("myzset", 2.0, "two");
     kv.zadd("myzset", 0.5, "zero");
-    auto vals = kv.zrange("myzset", 0, -1);
+    auto vals = *kv.zrange("myzset", 0, -1);
     ASSERT_EQ(vals.size(), 3);
-    EXPECT_EQ(vals[0], "zero");
-    EXPECT_EQ(vals[1], "one");
-    EXPECT_EQ(vals[2], "two");
+    EXPECT_EQ(vals[0].member, "zero");
+    EXPECT_EQ(vals[1].member, "one");
+    EXPECT_EQ(vals[2].member, "two");
     kv.zrem("myzset", "one");
-    vals = kv.zrange("myzset", 0, -1);
+    vals = *kv.zrange("myzset", 0, -1);
     ASSERT_EQ(vals.size(), 2);
-    EXPECT_EQ(vals[0], "zero");
-    EXPECT_EQ(vals[1], "two");
-    EXPECT_THROW(kv.zrange("notfound", 0, -1), std::runtime_error);
+    EXPECT_EQ(vals[0].member, "zero");
+    EXPECT_EQ(vals[1].member, "two");
+    EXPECT_EQ(kv.zrange("notfound", 0, -1).error(), StoreError::NoKey);
 }
 
 // Type safety
@@ -102,5 +161,606 @@ TEST(KeyValueStoreTest, TypeSafety)
     kv.lpush("mylist", "a");
     EXPECT_NO_THROW(kv.set("mylist", "str")); // Overwrites "mylist" as a string
     kv.sadd("myset", "x");
-    EXPECT_THROW(kv.hget("myset", "field"), std::runtime_error); // Wrong type get
+    EXPECT_EQ(kv.hget("myset", "field").error(), StoreError::WrongType); // Wrong type get
+    EXPECT_EQ(kv.get("myset").error(), StoreError::WrongType);
+    EXPECT_EQ(kv.srem("nothing", "x").error(), StoreError::NoKey);
+}
+
+// Keys, fields and members given as views into a larger buffer
+TEST(KeyValueStoreTest, ViewKeys)
+{
+    KeyValueStore kv;
+    std::string buffer = "user:1000 name field";
+    std::string_view key(buffer.data(), 9);
+    std::string_view field(buffer.data() + 15, 5);
+    kv.set(key, "first");
+    kv.set(key, "second"); // Overwrites in place
+    EXPECT_EQ(*kv.get("user:1000"), "second");
+    EXPECT_TRUE(kv.hset("h", field, "v1"));
+    EXPECT_FALSE(kv.hset("h", field, "v2"));
+    EXPECT_EQ(*kv.hget("h", "field"), "v2");
+    EXPECT_TRUE(*kv.hdel("h", field));
+    kv.sadd(std::string_view(buffer.data() + 10, 4), "x");
+    EXPECT_EQ(*kv.srem("name", std::string_view("xyz", 1)), 1u);
+    EXPECT_TRUE(kv.del(key));
+    EXPECT_FALSE(kv.exists(key));
+}
+
+// Variadic operations, each against one lookup of its key
+TEST(KeyValueStoreTest, BatchOperations)
+{
+    KeyValueStore kv;
+    std::string_view pairs[] = { "a", "1", "b", "2", "a", "3" };
+    kv.mset(pairs);
+    kv.sadd("s", "x");
+    std::string_view keys[] = { "a", "missing", "b", "s" };
+    EXPECT_EQ(kv.mget(keys), (std::vector<std::optional<std::string>> { "3", std::nullopt, "2", std::nullopt }));
+    EXPECT_EQ(kv.exists(keys), 3u);
+    std::string_view twice[] = { "a", "a" };
+    EXPECT_EQ(kv.exists(twice), 2u);
+    EXPECT_EQ(kv.del(keys), 3u);
+    EXPECT_EQ(kv.exists(keys), 0u);
+
+    std::string_view values[] = { "a", "b", "c" };
+    EXPECT_EQ(kv.lpush("l", values), 3u);
+    EXPECT_EQ(kv.rpush("l", values), 6u);
+    EXPECT_EQ(*kv.lrange("l", 0, -1), (std::vector<std::string> { "c", "b", "a", "a", "b", "c" }));
+    EXPECT_EQ(*kv.lpop("l", 2), (std::vector<std::string> { "c", "b" }));
+    EXPECT_EQ(*kv.rpop("l", 10), (std::vector<std::string> { "c", "b", "a", "a" }));
+    EXPECT_FALSE(kv.exists("l"));
+    EXPECT_EQ(kv.lpop("l", 1).error(), StoreError::NoKey);
+
+    std::string_view members[] = { "1", "2", "2", "3" };
+    EXPECT_EQ(kv.sadd("s", members), 3u);
+    EXPECT_STREQ(*kv.encoding("s"), "intset");
+    std::string_view gone[] = { "1", "2", "3", "4" };
+    EXPECT_EQ(*kv.srem("s", gone), 3u);
+    EXPECT_FALSE(kv.exists("s"));
+
+    std::string_view fields[] = { "f1", "v1", "f2", "v2", "f1", "v3" };
+    EXPECT_EQ(kv.hset("h", fields), 2u);
+    std::string_view names[] = { "f1", "f3", "f2" };
+    EXPECT_EQ(*kv.hmget("h", names), (std::vector<std::optional<std::string>> { "v3", std::nullopt, "v2" }));
+    EXPECT_EQ(*kv.hmget("nohash", names), (std::vector<std::optional<std::string>>(3)));
+    EXPECT_EQ(*kv.hdel("h", names), 2u);
+    EXPECT_FALSE(kv.exists("h"));
+
+    std::pair<double, std::string_view> entries[] = { { 2, "b" }, { 1, "a" }, { 3, "b" } };
+    EXPECT_EQ(kv.zadd("z", entries), 2u);
+    EXPECT_EQ(*kv.zscore("z", "b"), 3);
+    std::string_view zmembers[] = { "a", "c" };
+    EXPECT_EQ(*kv.zrem("z", zmembers), 1u);
+
+    kv.set("str", "v");
+    EXPECT_EQ(kv.hmget("str", names).error(), StoreError::WrongType);
+    EXPECT_EQ(kv.lpop("str", 1).error(), StoreError::WrongType);
+}
+
+// FlatHashMap
+TEST(FlatHashMapTest, InsertFindErase)
+{
+    FlatHashMap<std::string, int, StringHash, std::equal_to<>> map;
+    EXPECT_EQ(map.find(std::string_view("missing")), map.end());
+    auto [it, inserted] = map.try_emplace(std::string_view("a"), 1);
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(it->first, "a");
+    EXPECT_FALSE(map.try_emplace(std::string_view("a"), 2).second);
+    EXPECT_EQ(map.find(std::string_view("a"))->second, 1);
+    EXPECT_FALSE(map.insert_or_assign(std::string("a"), 3).second);
+    EXPECT_EQ(map.find(std::string_view("a"))->second, 3);
+    EXPECT_EQ(map.erase(std::string_view("a")), 1u);
+    EXPECT_EQ(map.erase(std::string_view("a")), 0u);
+    EXPECT_TRUE(map.empty());
+}
+
+TEST(FlatHashMapTest, MatchesUnorderedMap)
+{
+    FlatHashMap<int, int> map;
+    std::unordered_map<int, int> expected;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 200000; ++i) {
+        int key = static_cast<int>(rng() % 5000);
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(map.erase(key), expected.erase(key));
+        } else {
+            map.insert_or_assign(key, i);
+            expected.insert_or_assign(key, i);
+        }
+    }
+    ASSERT_EQ(map.size(), expected.size());
+    size_t visited = 0;
+    for (const auto& [key, value] : map) {
+        ++visited;
+        EXPECT_EQ(expected.at(key), value);
+    }
+    EXPECT_EQ(visited, expected.size());
+    // Churning over a bounded key set reuses tombstones instead of growing
+    EXPECT_LE(map.capacity(), 8192u);
+}
+
+namespace {
+size_t heapInUse()
+{
+#if defined(__GLIBC__)
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd; // Large tables are mmapped
+#else
+    return 0;
+#endif
+}
+
+// Builds a keyspace-shaped map, then times hits in random order. Keys fit in
+// the string's inline buffer, so the heap holds only the map's own memory.
+// The flat map's bytes per key swing with its load factor, between 7/16 and
+// 7/8 of capacity.
+template <typename Map>
+void benchmarkKeyspace(const char* name, const std::vector<std::string>& keys, const std::vector<size_t>& order)
+{
+    size_t before = heapInUse();
+    Map map;
+    for (const auto& key : keys)
+        map.try_emplace(key, RedisObject("v"));
+    size_t bytes = heapInUse() - before;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t hits = 0;
+    for (size_t i : order)
+        hits += map.contains(std::string_view(keys[i]));
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(hits, order.size());
+    std::cout << "[ BENCH    ] " << name << ": " << elapsed / order.size() << " ns/lookup";
+    if (bytes)
+        std::cout << ", " << static_cast<double>(bytes) / keys.size() << " bytes/key";
+    std::cout << std::endl;
+}
+} // namespace
+
+TEST(FlatHashMapTest, BenchmarkAgainstUnorderedMap)
+{
+    constexpr size_t KEYS = 200000;
+    std::vector<std::string> keys;
+    keys.reserve(KEYS);
+    for (size_t i = 0; i < KEYS; ++i)
+        keys.push_back("key:" + std::to_string(i));
+    std::vector<size_t> order(KEYS);
+    for (size_t i = 0; i < KEYS; ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+
+    benchmarkKeyspace<std::unordered_map<std::string, RedisObject, StringHash, std::equal_to<>>>("unordered_map", keys, order);
+    benchmarkKeyspace<FlatHashMap<std::string, RedisObject, StringHash, std::equal_to<>>>("FlatHashMap", keys, order);
+    benchmarkKeyspace<Keyspace>("Dict", keys, order);
+}
+
+// Dict
+TEST(DictTest, LookupsSeeBothTablesWhileRehashing)
+{
+    Dict<int, int> dict;
+    size_t rehashes = 0;
+    size_t insertsWhileRehashing = 0;
+    for (int i = 0; i < 100000; ++i) {
+        bool before = dict.rehashing();
+        dict.try_emplace(i, i * 2);
+        if (!before && dict.rehashing())
+            ++rehashes;
+        if (dict.rehashing()) {
+            ++insertsWhileRehashing;
+            // Keys from before the resize, moved or not, are all still there
+            for (int key : { 0, i / 2, i - 1, i }) {
+                ASSERT_NE(dict.find(key), nullptr) << key;
+                ASSERT_EQ(*dict.find(key), key * 2);
+            }
+        }
+    }
+    EXPECT_GT(rehashes, 5u);
+    // Each resize is spread over many inserts, not done by one
+    EXPECT_GT(insertsWhileRehashing, rehashes * 10);
+    EXPECT_EQ(dict.size(), 100000u);
+}
+
+TEST(DictTest, EraseAndOverwriteWhileRehashing)
+{
+    Dict<std::string, int, StringHash, std::equal_to<>> dict;
+    int i = 0;
+    while (!dict.rehashing())
+        dict.try_emplace("key:" + std::to_string(i++), 0);
+    EXPECT_FALSE(dict.try_emplace(std::string_view("key:0"), 1).second);
+    EXPECT_EQ(dict.erase(std::string_view("key:1")), 1u);
+    EXPECT_EQ(dict.find(std::string_view("key:1")), nullptr);
+    EXPECT_EQ(dict.erase(std::string_view("key:1")), 0u);
+
+    EXPECT_FALSE(dict.rehashFor(std::chrono::seconds(1)));
+    EXPECT_EQ(dict.size(), static_cast<size_t>(i - 1));
+    EXPECT_EQ(*dict.find(std::string_view("key:0")), 0);
+    EXPECT_EQ(dict.find(std::string_view("key:1")), nullptr);
+}
+
+// ZSet
+TEST(ZSetTest, OrdersByScoreThenMember)
+{
+    ZSet zset;
+    EXPECT_TRUE(zset.insert("b", 1));
+    EXPECT_TRUE(zset.insert("a", 1)); // Same score: both kept, ordered by member
+    EXPECT_TRUE(zset.insert("c", 0));
+    EXPECT_FALSE(zset.insert("c", 2)); // Moves c to the end
+    std::vector<std::string> order;
+    zset.forEachInRank(0, 2, false, [&](std::string_view member, double) { order.emplace_back(member); });
+    EXPECT_EQ(order, (std::vector<std::string> { "a", "b", "c" }));
+    EXPECT_EQ(*zset.rank("c"), 2u);
+    EXPECT_EQ(*zset.score("c"), 2);
+    order.clear();
+    zset.forEachInRank(0, 1, true, [&](std::string_view member, double) { order.emplace_back(member); });
+    EXPECT_EQ(order, (std::vector<std::string> { "c", "b" }));
+
+    EXPECT_TRUE(zset.erase("a"));
+    EXPECT_FALSE(zset.erase("a"));
+    EXPECT_FALSE(zset.rank("a"));
+    EXPECT_EQ(*zset.rank("b"), 0u);
+    ZSet copy = zset;
+    EXPECT_EQ(*copy.rank("c"), 1u);
+    EXPECT_EQ(copy.size(), 2u);
+}
+
+TEST(ZSetTest, RanksMatchSortedOrder)
+{
+    ZSet zset;
+    std::set<std::pair<double, std::string>> expected;
+    std::unordered_map<std::string, double> scores;
+    std::mt19937 rng(3);
+    for (int i = 0; i < 50000; ++i) {
+        std::string member = "m" + std::to_string(rng() % 5000);
+        double score = static_cast<double>(rng() % 100);
+        if (auto it = scores.find(member); it != scores.end())
+            expected.erase({ it->second, member });
+        if (rng() % 4 == 0) {
+            EXPECT_EQ(zset.erase(member), scores.erase(member) > 0);
+        } else {
+            zset.insert(member, score);
+            scores[member] = score;
+            expected.insert({ score, member });
+        }
+    }
+    ASSERT_EQ(zset.size(), expected.size());
+    size_t rank = 0;
+    for (const auto& [score, member] : expected) {
+        ASSERT_EQ(*zset.rank(member), rank) << member;
+        ++rank;
+    }
+    auto it = expected.begin();
+    zset.forEachInRank(0, zset.size() - 1, false, [&](std::string_view member, double score) {
+        EXPECT_EQ(member, it->second);
+        EXPECT_EQ(score, it->first);
+        ++it;
+    });
+}
+
+TEST(ZSetTest, RankRangeByScore)
+{
+    ZSet zset;
+    for (int i = 0; i < 10; ++i)
+        zset.insert("m" + std::to_string(i), i / 2); // Scores 0, 0, 1, 1, ..., 4, 4
+    EXPECT_EQ(zset.rankRange({ 1, 2 }), std::make_pair(size_t { 2 }, size_t { 6 }));
+    EXPECT_EQ(zset.rankRange({ 1, 2, true, false }), std::make_pair(size_t { 4 }, size_t { 6 }));
+    EXPECT_EQ(zset.rankRange({ 1, 2, false, true }), std::make_pair(size_t { 2 }, size_t { 4 }));
+    EXPECT_EQ(zset.rankRange({ 3, 1 }).second - zset.rankRange({ 3, 1 }).first, 0u);
+    EXPECT_EQ(*zset.incrementBy("m0", 10), 10);
+    EXPECT_EQ(*zset.rank("m0"), 9u);
+    EXPECT_FALSE(zset.incrementBy("new", std::nan("")));
+    EXPECT_FALSE(zset.score("new"));
+}
+
+// ListPack and QuickList
+TEST(ListPackTest, WalksBothWays)
+{
+    ListPack pack;
+    std::string big(300, 'x'); // Needs two-byte lengths
+    pack.pushBack("b");
+    pack.pushFront("a");
+    pack.pushBack(big);
+    pack.pushBack("");
+    ASSERT_EQ(pack.size(), 4u);
+    std::vector<std::string> forward, backward;
+    for (auto pos = pack.begin(); pos != pack.end(); pos = pack.next(pos))
+        forward.emplace_back(pack.at(pos));
+    for (auto pos = pack.end(); pos != pack.begin();) {
+        pos = pack.prev(pos);
+        backward.emplace_back(pack.at(pos));
+    }
+    EXPECT_EQ(forward, (std::vector<std::string> { "a", "b", big, "" }));
+    EXPECT_EQ(backward, (std::vector<std::string> { "", big, "b", "a" }));
+    EXPECT_EQ(pack.bytes(), ListPack::entrySize(1) * 2 + ListPack::entrySize(300) + ListPack::entrySize(0));
+
+    auto second = pack.next(pack.begin());
+    pack.replace(second, pack.at(pack.begin()));
+    EXPECT_EQ(pack.at(second), "a");
+    pack.popBack();
+    EXPECT_EQ(pack.back(), big);
+    pack.popFront();
+    EXPECT_EQ(pack.front(), "a");
+}
+
+TEST(QuickListTest, SpansNodes)
+{
+    QuickList list;
+    for (int i = 0; i < 5000; ++i)
+        list.pushBack("value:" + std::to_string(i));
+    for (int i = 1; i <= 5000; ++i)
+        list.pushFront("value:-" + std::to_string(i));
+    EXPECT_GT(list.nodeCount(), 2u);
+    ASSERT_EQ(list.size(), 10000u);
+
+    std::vector<std::string> range;
+    list.forEachInRange(4998, 5001, [&](std::string_view value) { range.emplace_back(value); });
+    EXPECT_EQ(range, (std::vector<std::string> { "value:-2", "value:-1", "value:0", "value:1" }));
+
+    EXPECT_EQ(list.popFront(), "value:-5000");
+    EXPECT_EQ(list.popBack(), "value:4999");
+    while (list.size() > 1)
+        list.popBack();
+    EXPECT_EQ(list.popFront(), "value:-4999");
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.nodeCount(), 0u);
+}
+
+// A job queue fed at the head and drained from the tail
+TEST(QuickListTest, BenchmarkMillionElementQueue)
+{
+    constexpr size_t ELEMENTS = 1000000;
+    KeyValueStore kv;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ELEMENTS; ++i)
+        kv.lpush("queue", "job:" + std::to_string(i));
+    auto pushed = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ELEMENTS; ++i)
+        ASSERT_EQ(*kv.rpop("queue"), "job:" + std::to_string(i));
+    auto drained = std::chrono::steady_clock::now();
+    EXPECT_FALSE(kv.exists("queue"));
+
+    using Nanos = std::chrono::duration<double, std::nano>;
+    std::cout << "[ BENCH    ] LPUSH " << Nanos(pushed - start).count() / ELEMENTS << " ns/op, RPOP "
+              << Nanos(drained - pushed).count() / ELEMENTS << " ns/op over " << ELEMENTS << " elements" << std::endl;
+}
+
+// Packed encodings
+TEST(EncodingTest, HashConvertsPastLimits)
+{
+    EncodingLimits limits;
+    limits.hashMaxListpackEntries = 4;
+    limits.hashMaxListpackValue = 8;
+    KeyValueStore kv(limits);
+    for (int i = 0; i < 4; ++i)
+        kv.hset("small", "f" + std::to_string(i), "v");
+    EXPECT_STREQ(*kv.encoding("small"), "listpack");
+    EXPECT_TRUE(kv.hset("small", "f4", "v"));
+    EXPECT_STREQ(*kv.encoding("small"), "hashtable");
+    EXPECT_EQ(kv.hgetall("small")->size(), 5u);
+    EXPECT_EQ(*kv.hget("small", "f0"), "v");
+
+    kv.hset("long", "f", "short");
+    EXPECT_FALSE(kv.hset("long", "f", "longer than eight"));
+    EXPECT_STREQ(*kv.encoding("long"), "hashtable");
+    EXPECT_EQ(*kv.hget("long", "f"), "longer than eight");
+}
+
+TEST(EncodingTest, SetAndListConvertPastLimits)
+{
+    EncodingLimits limits;
+    limits.setMaxListpackEntries = 2;
+    limits.listMaxListpackBytes = 64;
+    KeyValueStore kv(limits);
+    kv.sadd("set", "a");
+    kv.sadd("set", "b");
+    EXPECT_STREQ(*kv.encoding("set"), "listpack");
+    kv.sadd("set", "c");
+    EXPECT_STREQ(*kv.encoding("set"), "hashtable");
+    EXPECT_EQ(*kv.srem("set", "b"), true);
+    EXPECT_EQ(kv.smembers("set")->size(), 2u);
+
+    for (int i = 0; i < 10; ++i)
+        kv.rpush("list", "item:" + std::to_string(i));
+    EXPECT_STREQ(*kv.encoding("list"), "quicklist");
+    auto items = *kv.lrange("list", 0, -1);
+    ASSERT_EQ(items.size(), 10u);
+    EXPECT_EQ(items.front(), "item:0");
+    EXPECT_EQ(items.back(), "item:9");
+
+    kv.set("str", "v");
+    EXPECT_STREQ(*kv.encoding("str"), "embstr");
+    kv.zadd("zset", 1, "m");
+    EXPECT_STREQ(*kv.encoding("zset"), "skiplist");
+    EXPECT_EQ(kv.encoding("missing").error(), StoreError::NoKey);
+}
+
+TEST(IntSetTest, StaysSortedAndWidens)
+{
+    IntSet ints;
+    EXPECT_TRUE(ints.insert(5));
+    EXPECT_TRUE(ints.insert(-3));
+    EXPECT_FALSE(ints.insert(5));
+    EXPECT_EQ(ints.width(), 2u);
+    EXPECT_TRUE(ints.insert(100000));
+    EXPECT_EQ(ints.width(), 4u);
+    EXPECT_TRUE(ints.insert(INT64_MIN));
+    EXPECT_EQ(ints.width(), 8u);
+    EXPECT_EQ(ints.bytes(), 4 * sizeof(int64_t));
+
+    std::vector<int64_t> values;
+    ints.forEach([&](int64_t value) { values.push_back(value); });
+    EXPECT_EQ(values, (std::vector<int64_t> { INT64_MIN, -3, 5, 100000 }));
+    EXPECT_TRUE(ints.contains(100000));
+    EXPECT_FALSE(ints.contains(4));
+    EXPECT_TRUE(ints.erase(-3));
+    EXPECT_FALSE(ints.erase(-3));
+    EXPECT_EQ(ints.size(), 3u);
+
+    EXPECT_EQ(parseCanonicalInteger("-42"), -42);
+    EXPECT_EQ(parseCanonicalInteger("-9223372036854775808"), INT64_MIN);
+    EXPECT_FALSE(parseCanonicalInteger("007"));
+    EXPECT_FALSE(parseCanonicalInteger("+7"));
+    EXPECT_FALSE(parseCanonicalInteger("-0"));
+    EXPECT_FALSE(parseCanonicalInteger("9223372036854775808"));
+    EXPECT_FALSE(parseCanonicalInteger("1.5"));
+}
+
+TEST(EncodingTest, IntSetConvertsOnStringOrSize)
+{
+    EncodingLimits limits;
+    limits.setMaxIntsetEntries = 3;
+    KeyValueStore kv(limits);
+    kv.sadd("ids", "3");
+    kv.sadd("ids", "1");
+    EXPECT_STREQ(*kv.encoding("ids"), "intset");
+    EXPECT_TRUE(*kv.sismember("ids", "1"));
+    EXPECT_FALSE(*kv.sismember("ids", "01"));
+    kv.sadd("ids", "01");
+    EXPECT_STREQ(*kv.encoding("ids"), "listpack");
+    EXPECT_TRUE(*kv.sismember("ids", "01"));
+    EXPECT_TRUE(*kv.sismember("ids", "3"));
+
+    for (int i = 0; i < 3; ++i)
+        kv.sadd("many", std::to_string(i));
+    EXPECT_STREQ(*kv.encoding("many"), "intset");
+    kv.sadd("many", "3");
+    EXPECT_STREQ(*kv.encoding("many"), "hashtable");
+    auto members = *kv.smembers("many");
+    std::sort(members.begin(), members.end());
+    EXPECT_EQ(members, (std::vector<std::string> { "0", "1", "2", "3" }));
+    EXPECT_EQ(kv.sismember("none", "1").error(), StoreError::NoKey);
+}
+
+namespace {
+std::vector<std::string> sorted(std::vector<std::string> members)
+{
+    std::sort(members.begin(), members.end());
+    return members;
+}
+} // namespace
+
+TEST(SetAlgebraTest, MixedEncodings)
+{
+    KeyValueStore kv;
+    for (const char* member : { "1", "2", "3", "4" })
+        kv.sadd("ints", member);
+    for (const char* member : { "3", "4", "5", "x" })
+        kv.sadd("mixed", member);
+    for (int i = 0; i < 200; ++i)
+        kv.sadd("big", "m" + std::to_string(i));
+    kv.sadd("big", "4");
+    ASSERT_STREQ(*kv.encoding("ints"), "intset");
+    ASSERT_STREQ(*kv.encoding("mixed"), "listpack");
+    ASSERT_STREQ(*kv.encoding("big"), "hashtable");
+
+    std::vector<std::string_view> keys = { "ints", "mixed" };
+    using Members = std::vector<std::string>;
+    EXPECT_EQ(sorted(*kv.sinter(keys)), (Members { "3", "4" }));
+    EXPECT_EQ(sorted(*kv.sunion(keys)), (Members { "1", "2", "3", "4", "5", "x" }));
+    EXPECT_EQ(sorted(*kv.sdiff(keys)), (Members { "1", "2" }));
+    keys = { "big", "mixed", "ints" };
+    EXPECT_EQ(*kv.sinter(keys), (Members { "4" }));
+    EXPECT_EQ(*kv.sintercard(keys), 1u);
+    EXPECT_EQ(kv.sunion(keys)->size(), 206u);
+
+    keys = { "ints", "missing" };
+    EXPECT_TRUE(kv.sinter(keys)->empty());
+    EXPECT_EQ(kv.sunion(keys)->size(), 4u);
+    EXPECT_EQ(kv.sdiff(keys)->size(), 4u);
+    kv.set("str", "v");
+    keys = { "ints", "str" };
+    EXPECT_EQ(kv.sinter(keys).error(), StoreError::WrongType);
+}
+
+TEST(SetAlgebraTest, IntSetIntersection)
+{
+    KeyValueStore kv;
+    for (int i = 0; i < 300; ++i)
+        kv.sadd("evens", std::to_string(i * 2));
+    for (int i = 0; i < 200; ++i)
+        kv.sadd("triples", std::to_string(i * 3 - 30));
+    kv.sadd("wide", "6");
+    kv.sadd("wide", "5000000000");
+    std::vector<std::string_view> keys = { "evens", "triples" };
+    auto common = *kv.sinter(keys);
+    ASSERT_EQ(common.size(), 95u); // 0, 6, ... 564
+    EXPECT_EQ(common.front(), "0");
+    EXPECT_EQ(common.back(), "564");
+    EXPECT_EQ(*kv.sintercard(keys, 10), 10u);
+
+    keys = { "evens", "triples", "wide" };
+    EXPECT_EQ(*kv.sinter(keys), std::vector<std::string> { "6" });
+
+    keys = { "evens", "triples" };
+    EXPECT_EQ(*kv.sinterstore("common", keys), 95u);
+    EXPECT_STREQ(*kv.encoding("common"), "intset");
+    // The destination may be a source
+    keys = { "common", "wide" };
+    EXPECT_EQ(*kv.sunionstore("common", keys), 96u);
+    EXPECT_EQ(*kv.sdiffstore("common", keys), 94u);
+    keys = { "common", "common" };
+    EXPECT_EQ(*kv.sdiffstore("common", keys), 0u);
+    EXPECT_FALSE(kv.exists("common"));
+}
+
+TEST(RedisObjectTest, StringEncodings)
+{
+    struct Case {
+        std::string value;
+        const char* encoding;
+    };
+    for (const auto& [value, encoding] : std::vector<Case> {
+             { "12345", "int" },
+             { "-9223372036854775808", "int" },
+             { "9223372036854775808", "raw" },
+             { "007", "embstr" },
+             { "", "embstr" },
+             { "fifteen bytes!!", "embstr" },
+             { "sixteen bytes!!!", "raw" },
+             { std::string(1000, 'x'), "raw" },
+         }) {
+        RedisObject object(value);
+        EXPECT_EQ(object.type(), RedisObject::Type::String);
+        EXPECT_STREQ(object.encoding(), encoding) << value;
+        EXPECT_EQ(object.string(), value);
+        RedisObject copy(object);
+        RedisObject moved(std::move(object));
+        EXPECT_EQ(copy.string(), value);
+        EXPECT_EQ(moved.string(), value);
+        EXPECT_EQ(object.type(), RedisObject::Type::None);
+    }
+
+    RedisObject object(std::string(40, 'a'));
+    std::string before = object.string();
+    object.emplace<SetObject>().add("m", EncodingLimits());
+    EXPECT_EQ(object.type(), RedisObject::Type::Set);
+    EXPECT_EQ(object.get_if<HashObject>(), nullptr);
+    RedisObject copy = object;
+    EXPECT_TRUE(copy.get_if<SetObject>()->contains("m"));
+    object.setString(before);
+    EXPECT_EQ(object.string(), before);
+    EXPECT_TRUE(copy.get_if<SetObject>()->contains("m"));
+}
+
+// Many small hashes, as user records usually are: a listpack takes well
+// under half the heap of a hashtable
+TEST(EncodingTest, SmallHashMemory)
+{
+    constexpr size_t HASHES = 2000;
+    constexpr int FIELDS = 8;
+    EncodingLimits tableOnly;
+    tableOnly.hashMaxListpackEntries = 0;
+    size_t used[2];
+    int run = 0;
+    for (const auto& [name, limits] : { std::pair("listpack", EncodingLimits()), std::pair("hashtable", tableOnly) }) {
+        size_t before = heapInUse();
+        KeyValueStore kv(limits);
+        for (size_t i = 0; i < HASHES; ++i) {
+            std::string key = "user:" + std::to_string(i);
+            for (int f = 0; f < FIELDS; ++f)
+                kv.hset(key, "field:" + std::to_string(f), "value:" + std::to_string(i));
+        }
+        used[run++] = heapInUse() - before;
+        EXPECT_STREQ(*kv.encoding("user:0"), name);
+    }
+    if (used[1])
+        EXPECT_LT(used[0], used[1] / 2);
 }